@@ -0,0 +1,109 @@
+// Times every PixelScan kernel the CPU supports, against the scalar one, on the real map and on a synthetic 8K one
+// Run it from the build directory, so res/test.png is where the engine would look for it
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_ONLY_PNG
+#include <stb_image.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../src/pixel_scan/pixel_scan.hpp"
+
+#define BENCH_REPEATS 10 // Best of this many scans of the whole image
+#define BENCH_SYNTHETIC_WIDTH 7680
+#define BENCH_SYNTHETIC_HEIGHT 4320
+
+struct Image {
+  std::string name;
+  int width, height;
+  size_t channels;
+  std::vector<unsigned char> data;
+};
+
+// Same walk over the image as the map scan, one run at a time, counting them so nothing gets optimized away
+static size_t scan(const Image& image, const PixelScan& pixelScan) {
+  size_t runs = 0;
+  const auto width = static_cast<size_t>(image.width);
+  for (int y = 0; y < image.height; y++) {
+    const unsigned char* row = image.data.data() + static_cast<size_t>(y) * width * image.channels;
+    for (size_t x = 0; x < width; runs++) x = pixelScan.mismatch(row, x + 1, width, row + x * image.channels);
+  } return runs;
+}
+
+static Image withChannels(const Image& image, const size_t channels) {
+  Image converted{ image.name + " (" + std::to_string(channels) + " channels)", image.width, image.height,
+                   channels, {} };
+  const size_t pixels = static_cast<size_t>(image.width) * static_cast<size_t>(image.height);
+  converted.data.resize(pixels * channels, 0xFF);
+  for (size_t i = 0; i < pixels; i++)
+    std::copy_n(image.data.begin() + static_cast<std::ptrdiff_t>(i * image.channels), std::min<size_t>(channels, 3),
+                converted.data.begin() + static_cast<std::ptrdiff_t>(i * channels));
+  return converted;
+}
+
+// Bands of provinces as wide as the ones on real maps, from a few pixels to a few hundred, with repeats
+static Image synthetic() {
+  Image image{ "synthetic 8K", BENCH_SYNTHETIC_WIDTH, BENCH_SYNTHETIC_HEIGHT, 3, {} };
+  image.data.resize(static_cast<size_t>(image.width) * static_cast<size_t>(image.height) * 3);
+  std::mt19937 random(8192);
+  std::uniform_int_distribution<int> widths(4, 400), channel(0, 255), bandHeights(8, 96);
+  for (int y = 0; y < image.height;) {
+    const int bandEnd = std::min(image.height, y + bandHeights(random));
+    std::vector<unsigned char> row(static_cast<size_t>(image.width) * 3);
+    for (int x = 0; x < image.width;) {
+      const int end = std::min(image.width, x + widths(random));
+      const unsigned char color[3] = { static_cast<unsigned char>(channel(random)),
+                                       static_cast<unsigned char>(channel(random)),
+                                       static_cast<unsigned char>(channel(random)) };
+      for (; x < end; x++) std::copy_n(color, 3, row.begin() + x * 3);
+    }
+    for (; y < bandEnd; y++) std::ranges::copy(row, image.data.begin() + static_cast<std::ptrdiff_t>(y) * image.width * 3);
+  } return image;
+}
+
+static void benchmark(const Image& image) {
+  std::printf("%s, %dx%d\n", image.name.c_str(), image.width, image.height);
+  double scalarTime = 0.0;
+  size_t expected = 0;
+  for (const auto level : { PixelScan::SCALAR, PixelScan::SSE2, PixelScan::AVX2 }) {
+    const PixelScan pixelScan(image.channels, level);
+    if (pixelScan.getLevel() != level) continue; // Not supported here, so it would only time another kernel again
+
+    double best = 0.0;
+    size_t runs = 0;
+    for (int i = 0; i < BENCH_REPEATS; i++) {
+      const auto start = std::chrono::steady_clock::now();
+      runs = scan(image, pixelScan);
+      const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      if (i == 0 || time < best) best = time;
+    }
+    if (level == PixelScan::SCALAR) {
+      scalarTime = best;
+      expected = runs;
+    }
+    std::printf("  %-6s %8.3fms  %5.2fx  %zu runs%s\n", pixelScan.getKernelName().c_str(), best, scalarTime / best,
+                runs, runs == expected ? "" : "  MISMATCH");
+  }
+}
+
+int main(const int argc, char** argv) {
+  const std::string mapPath = argc > 1 ? argv[1] : "res/test.png";
+  Image map{ mapPath, 0, 0, 0, {} };
+  int channels = 0;
+  if (unsigned char* data = stbi_load(mapPath.c_str(), &map.width, &map.height, &channels, 0)) {
+    map.channels = static_cast<size_t>(channels);
+    map.data.assign(data, data + static_cast<size_t>(map.width) * static_cast<size_t>(map.height) * map.channels);
+    stbi_image_free(data);
+    benchmark(withChannels(map, 3));
+    benchmark(withChannels(map, 4));
+  } else std::printf("Could not load \"%s\", only running the synthetic map\n", mapPath.c_str());
+
+  const Image map8k = synthetic();
+  benchmark(map8k);
+  benchmark(withChannels(map8k, 4));
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Times the three ways of setting a uniform: asking GL for its location every time, the string setters and the
+// Shader::Uniform handles. Needs a GL 4.6 context, so it opens a hidden window; run it from the build directory
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+#include "../src/shader/shader.hpp"
+#include "../src/error_handler/error_handler.h"
+
+#define BENCH_CALLS 1000000 // Uniform sets per way, each one setting a float and a vec4
+#define BENCH_REPEATS 5
+
+// Best time of a few, in nanoseconds per call, waiting for the driver to actually be done with all of them
+static double benchmark(const std::function<void(int)>& set) {
+  double best = 0.0;
+  for (int repeat = 0; repeat < BENCH_REPEATS; repeat++) {
+    glFinish();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_CALLS; i++) set(i);
+    glFinish();
+    const double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (repeat == 0 || time < best) best = time;
+  } return best / BENCH_CALLS;
+}
+
+int main() {
+  ErrorHandler errorHandler(static_cast<ErrorHandler::LogLevel>(ErrorHandler::LOG_WARNING |
+                                                                ErrorHandler::LOG_ERROR));
+  if (!glfwInit()) errorHandler.logFatal("Failed to initialize GLFW", ErrorHandler::WINDOW_CREATION_ERROR);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+  GLFWwindow* window = glfwCreateWindow(64, 64, "Uniform benchmark", nullptr, nullptr);
+  if (!window) errorHandler.logFatal("Failed to create window", ErrorHandler::WINDOW_CREATION_ERROR);
+  glfwMakeContextCurrent(window);
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress)))
+    errorHandler.logFatal("Failed to initialize GLAD", ErrorHandler::WINDOW_CREATION_ERROR);
+
+  {
+    // Has a float and a vec4 uniform, like most of what gets set every frame
+    const Shader shader(&errorHandler, "res/shaders/map");
+    shader.use();
+    const Shader::Uniform width = shader.getUniform("provinceBorderWidth");
+    const Shader::Uniform color = shader.getUniform("provinceBorderColor");
+    if (width.location < 0 || color.location < 0)
+      errorHandler.logFatal("res/shaders/map doesn't have the uniforms being timed", ErrorHandler::UNKNOWN_ERROR);
+
+    const double locations = benchmark([&](const int i) {
+      const auto value = static_cast<float>(i & 1);
+      glUniform1f(glGetUniformLocation(shader.ID, "provinceBorderWidth"), value);
+      glUniform4f(glGetUniformLocation(shader.ID, "provinceBorderColor"), value, value, value, 1.0f);
+    });
+    const double names = benchmark([&](const int i) {
+      const auto value = static_cast<float>(i & 1);
+      shader.setFloat("provinceBorderWidth", value);
+      shader.setVec4f("provinceBorderColor", value, value, value, 1.0f);
+    });
+    const double handles = benchmark([&](const int i) {
+      const auto value = static_cast<float>(i & 1);
+      shader.setFloat(width, value);
+      shader.setVec4f(color, value, value, value, 1.0f);
+    });
+
+    std::printf("%s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    std::printf("  glGetUniformLocation every call  %8.1fns\n", locations);
+    std::printf("  string setters                   %8.1fns  %5.2fx\n", names, locations / names);
+    std::printf("  Shader::Uniform handles          %8.1fns  %5.2fx\n", handles, locations / handles);
+    glDeleteProgram(shader.ID);
+  }
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return 0;
+}
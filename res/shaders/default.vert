@@ -1,12 +1,33 @@
 #version 460 core
 layout (location = 0) in vec2 aPos;
 
-uniform float scale;
-uniform vec2 offset;
-uniform vec3 color;
-uniform vec2 center;
+// All indexed by province, which every draw gets as its base instance
+layout (std430, binding = 0) readonly buffer Centers {
+  vec2 centers[];
+};
+layout (binding = 0) uniform samplerBuffer colors;
+layout (binding = 3) uniform samplerBuffer values; // Negative keeps the province's own color
+layout (binding = 4) uniform sampler1D ramp; // What map modes turn values into colors with
+
+uniform bool mapMode;
+
+layout (std140, binding = 0) uniform Camera {
+  vec2 offset;
+  float scale;
+};
+
+flat out vec3 color;
+
+vec3 provinceColor(int province) { // Its own color, or its value on the ramp when there's a map mode
+  float value = texelFetch(values, province).r;
+  if (!mapMode || value < 0.0) return texelFetch(colors, province).rgb;
+  float size = float(textureSize(ramp, 0)); // Sample the middle of the first and last stops at 0 and 1
+  return texture(ramp, (min(value, 1.0) * (size - 1.0) + 0.5) / size).rgb;
+}
 
 void main() {
   // Make the shape scale around its center
+  vec2 center = centers[gl_BaseInstance];
   gl_Position = vec4((aPos - center) * 0.9 + center - offset, 0.0, scale);
+  color = provinceColor(gl_BaseInstance);
 }
@@ -1,8 +1,10 @@
 #version 460 core
 layout (location = 0) in vec2 aPos;
 
-uniform float scale;
-uniform vec2 offset;
+layout (std140, binding = 0) uniform Camera {
+    vec2 offset;
+    float scale;
+};
 
 void main() {
     gl_Position = vec4(aPos * 0.95 - offset, 0.0, scale);
@@ -0,0 +1,58 @@
+#version 460 core
+in vec2 mapPos;
+out vec4 fragColor;
+
+layout (binding = 0) uniform samplerBuffer colors; // Indexed by province
+layout (binding = 1) uniform usampler2D provinces; // Province of every pixel of the map
+layout (binding = 2) uniform usamplerBuffer owners; // Indexed by province
+layout (binding = 3) uniform samplerBuffer values; // Indexed by province, negative keeps the province's own color
+layout (binding = 4) uniform sampler1D ramp; // What map modes turn values into colors with
+
+uniform bool mapMode;
+
+// Widths are in screen pixels
+uniform float provinceBorderWidth;
+uniform vec4 provinceBorderColor;
+uniform float stateBorderWidth;
+uniform vec4 stateBorderColor;
+
+const uint NONE = 0xFFFFu;
+
+vec3 provinceColor(int province) { // Its own color, or its value on the ramp when there's a map mode
+  float value = texelFetch(values, province).r;
+  if (!mapMode || value < 0.0) return texelFetch(colors, province).rgb;
+  float size = float(textureSize(ramp, 0)); // Sample the middle of the first and last stops at 0 and 1
+  return texture(ramp, (min(value, 1.0) * (size - 1.0) + 0.5) / size).rgb;
+}
+
+uint provinceAt(vec2 pixel) {
+  ivec2 size = textureSize(provinces, 0);
+  return texelFetch(provinces, clamp(ivec2(floor(pixel)), ivec2(0), size - 1), 0).r;
+}
+
+// Whether any province within the given distance (in map pixels) along the axes is a different one
+bool onBorder(vec2 pixel, vec2 distance, uint province, bool state) {
+  uint owner = texelFetch(owners, int(province)).r;
+  vec2 steps[4] = vec2[](vec2(distance.x, 0.0), vec2(-distance.x, 0.0), vec2(0.0, distance.y), vec2(0.0, -distance.y));
+  for (int i = 0; i < 4; i++) {
+    uint other = provinceAt(pixel + steps[i]);
+    if (other == province) continue;
+    if (!state || other == NONE || texelFetch(owners, int(other)).r != owner) return true;
+  } return false;
+}
+
+void main() {
+  if (any(greaterThanEqual(abs(mapPos), vec2(1.0)))) discard; // Outside the map
+
+  vec2 pixel = (vec2(mapPos.x, -mapPos.y) + 1.0) * 0.5 * vec2(textureSize(provinces, 0));
+  uint province = provinceAt(pixel);
+  if (province == NONE) discard; // Not part of any province
+
+  vec3 color = provinceColor(int(province));
+  vec2 halfWidth = 0.5 * fwidth(pixel); // Half a screen pixel, in map pixels, since both sides get their half
+  if (stateBorderWidth > 0.0 && onBorder(pixel, stateBorderWidth * halfWidth, province, true))
+    color = mix(color, stateBorderColor.rgb, stateBorderColor.a);
+  else if (provinceBorderWidth > 0.0 && onBorder(pixel, provinceBorderWidth * halfWidth, province, false))
+    color = mix(color, provinceBorderColor.rgb, provinceBorderColor.a);
+  fragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,14 @@
+#version 460 core
+layout (std140, binding = 0) uniform Camera {
+  vec2 offset;
+  float scale;
+};
+
+out vec2 mapPos;
+
+void main() {
+  // Fullscreen quad, straight out of the vertex index
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0;
+  gl_Position = vec4(corner, 0.0, 1.0);
+  mapPos = corner * scale + offset; // Undo what the province shader does, so both line up
+}
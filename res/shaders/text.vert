@@ -1,14 +1,16 @@
 #version 460 core
 layout (location = 0) in vec2 vertex;
 layout (location = 1) in vec2 texCoords;
+layout (location = 2) in vec2 center;
 
 out vec2 TexCoords;
 
-uniform vec2 offset;
-uniform float scale;
-uniform vec2 center;
+layout (std140, binding = 0) uniform Camera {
+  vec2 offset;
+  float scale;
+};
 
 void main() {
-  gl_Position = vec4((vertex - center) * 0.9 + center - offset, 0.0, scale);
+  gl_Position = vec4((center + vertex) * 0.9 + center - offset, 0.0, scale);
   TexCoords = texCoords;
 }  
@@ -0,0 +1,48 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glad/glad.h>
+
+#include "../utils.hpp"
+
+#define CAMERA_BINDING 0 // Uniform block binding of the camera, has to match every shader that uses it
+
+// Camera state shared by every shader program through a single uniform block, instead of per-program uniforms
+// Any shader that declares the Camera block at CAMERA_BINDING gets it, without anyone having to set anything
+class Camera {
+public:
+  Camera() { // Only create this once the GL context exists
+    glGenBuffers(1, &UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BINDING, UBO);
+  }
+  ~Camera() noexcept { glDeleteBuffers(1, &UBO); }
+
+  Camera(const Camera&) = delete;
+  Camera& operator=(const Camera&) = delete;
+
+  // Only uploads anything if the camera actually moved
+  void update(const float scale, const vec2f& offset) {
+    if (uploaded && scale == block.scale && offset == vec2f(block.offset[0], block.offset[1])) return;
+    block = { { offset.x, offset.y }, scale, 0.0f };
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    uploaded = true;
+  }
+
+private:
+  struct Block { // std140, has to match the Camera block in the shaders
+    float offset[2];
+    float scale;
+    float padding;
+  };
+
+  unsigned int UBO{};
+  Block block{};
+  bool uploaded = false;
+};
+
+#endif // CAMERA_H
@@ -0,0 +1,53 @@
+#ifndef COLOR_INDEX_H
+#define COLOR_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+// Maps packed 0xRRGGBB colors to dense indices, through a sorted array instead of a hash table
+class ColorIndex {
+public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  ColorIndex() = default;
+  // Every color maps to its position in the given list, or to the first one, if it's there more than once
+  explicit ColorIndex(const std::vector<uint32_t>& colors) {
+    std::vector<uint32_t> order(colors.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::ranges::stable_sort(order, {}, [&](const uint32_t i) { return colors[i]; });
+    for (const uint32_t i : order) {
+      if (!keys.empty() && keys.back() == colors[i]) {
+        duplicates++;
+        continue;
+      }
+      keys.push_back(colors[i]);
+      values.push_back(i);
+    }
+  }
+  ~ColorIndex() = default;
+
+  [[nodiscard]] size_t size() const { return keys.size(); }
+  [[nodiscard]] size_t getDuplicates() const { return duplicates; }
+
+  // Branchless lower bound, since colors on a map are pretty much random, and the branches would be too
+  [[nodiscard]] uint32_t find(const uint32_t color) const {
+    if (keys.empty()) return NONE;
+    const uint32_t* base = keys.data();
+    for (size_t length = keys.size(); length > 1;) {
+      const size_t half = length / 2;
+      base += (base[half] < color) * half;
+      length -= half;
+    } base += *base < color;
+    if (base == keys.data() + keys.size() || *base != color) return NONE;
+    return values[static_cast<size_t>(base - keys.data())];
+  }
+
+private:
+  std::vector<uint32_t> keys; // Sorted
+  std::vector<uint32_t> values;
+  size_t duplicates = 0;
+};
+
+#endif // COLOR_INDEX_H
@@ -0,0 +1,45 @@
+#ifndef COLOR_RAMP_H
+#define COLOR_RAMP_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+#include "../province/province.hpp"
+
+// A gradient kept on the GPU as a 1D texture, so shaders can turn any value from 0 to 1 into a color
+// The sampler blends in between the stops, which are spread evenly from one end to the other
+class ColorRamp {
+public:
+  ColorRamp() = default;
+  ~ColorRamp() noexcept { glDeleteTextures(1, &texture); }
+
+  ColorRamp(const ColorRamp&) = delete;
+  ColorRamp& operator=(const ColorRamp&) = delete;
+
+  // Only call this, and bind, from the thread that owns the GL context
+  void build(const std::vector<Province::Color>& stops) {
+    static_assert(sizeof(Province::Color) == 3, "Stops get uploaded just as they are");
+    if (texture == 0) glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Colors are 3 bytes each
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGB8, static_cast<GLsizei>(stops.size()), 0, GL_RGB, GL_UNSIGNED_BYTE,
+                 stops.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_1D, 0);
+  }
+
+  void bind(const unsigned int unit) const {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+private:
+  unsigned int texture{};
+};
+
+#endif // COLOR_RAMP_H
@@ -4,6 +4,7 @@
 #include <array>
 #include <string>
 #include <iostream>
+#include <mutex>
 #include <utility>
 
 // Just a simple error handler that can be set for different warning levels
@@ -72,8 +73,10 @@ public:
 
 private:
   LogLevel logLevel;
+  mutable std::mutex logMutex; // So messages logged from worker threads don't get mixed up
 
   void log(const std::string& prefix, const std::string& message, const ErrorCode errorCode, const bool error = false) const {
+    std::lock_guard lock(logMutex);
     if (error) std::cerr << prefix << " (" << errorMessages[errorCode] << ")" << (message.empty() ? "" : ": ") + message << std::endl;
     else std::cout << prefix << " (" << errorMessages[errorCode] << ")" << (message.empty() ? "" : ": ") + message << std::endl;
   }
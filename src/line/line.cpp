@@ -1,18 +1,11 @@
 #include "line.h"
 
-Line::Line(ErrorHandler* errorHandler, const std::vector<vec2f>& points) : errorHandler(errorHandler) {
-  generateMesh(points);
-  generateMeshData();
+Line::Line(ErrorHandler* errorHandler, const std::vector<vec2f>& points, const float scale) :
+errorHandler(errorHandler) {
+  generateMesh(points, scale);
 }
 
-void Line::render() const {
-  if (vertices.empty()) return; // Nothing to render
-  glBindVertexArray(VAO);
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLint>(vertices.size()));
-  glBindVertexArray(0);
-}
-
-void Line::generateMesh(const std::vector<vec2f>& points) {
+void Line::generateMesh(const std::vector<vec2f>& points, const float scale) {
   if (points.size() < 2) {
     errorHandler->logError("Line must have at least 2 points",
       ErrorHandler::ErrorCode::NOT_ENOUGH_LINE_ELEMENTS);
@@ -21,39 +14,30 @@ void Line::generateMesh(const std::vector<vec2f>& points) {
 
   length = 0.0f; // Reset length
 
-  // Catmull-Rom spline for smooth lines
+  // Catmull-Rom spline for smooth lines, every curve sampled all at once, with only as many samples as it needs
+  const float tolerance = CURVE_TOLERANCE * std::max(scale, 0.0f);
+  std::array<float, CURVE_SEGMENTS + 1> xs{}, ys{};
   const size_t n = points.size();
   for (size_t i = 0; i < n - 1; i++) {
     const vec2f& p0 = i == 0 ? points[i] + (points[i] - points[i + 1]).normalized() : points[i - 1];
     const vec2f& p3 = i + 2 < n ? points[i + 2] : points[i + 1] - (points[i] - points[i + 1]).normalized();
-    for (int j = 0; j < CURVE_SEGMENTS; j++) {
-      const float t = static_cast<float>(j) * CURVE_STEP;
-      addSegment(catmullRom(p0, points[i], points[i + 1], p3, t) * 2.0f, // Scale up because we're in NDC,
-             catmullRom(p0, points[i], points[i + 1], p3, t + CURVE_STEP) * 2.0f,
-             j == CURVE_SEGMENTS - 1 && i == n - 2);
+    const Curve curve = catmullRom(p0, points[i], points[i + 1], p3);
+    const int segments = curve.segments(tolerance);
+
+    // Kept apart from everything else, so the compiler can do several samples per instruction
+    const float step = 1.0f / static_cast<float>(segments);
+    for (int j = 0; j <= segments; j++) {
+      const float t = static_cast<float>(j) * step;
+      xs[j] = ((curve.a.x * t + curve.b.x) * t + curve.c.x) * t + curve.d.x;
+      ys[j] = ((curve.a.y * t + curve.b.y) * t + curve.c.y) * t + curve.d.y;
     }
+    for (int j = 0; j < segments; j++)
+      addSegment({ xs[j], ys[j] }, { xs[j + 1], ys[j + 1] }, j == segments - 1 && i == n - 2);
   }
 }
 
-void Line::generateMeshData() {
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-
-  // Bind VAO
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER,
-               static_cast<GLsizeiptr>(vertices.size() * sizeof(vec2f)),
-               &vertices[0],
-               GL_STATIC_DRAW);
-
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), nullptr);
-  glEnableVertexAttribArray(0);
-
-  glBindVertexArray(0);
-}
-
 void Line::addSegment(const vec2f& start, const vec2f& end, const bool final) {
+  if (start == end) return; // Nothing to point along, only happens if two points of the line are the same
   length += (end - start).length(); // Measure length, in a fairly precise manner
 
   const vec2f direction = (end - start).normalized();
@@ -75,25 +59,32 @@ void Line::addSegment(const vec2f& start, const vec2f& end, const bool final) {
   vertices.push_back(end - direction * 0.01f - perpendicular * 2.0f);
 }
 
-vec2f Line::catmullRom(const vec2f& p0, const vec2f& p1, const vec2f& p2, const vec2f& p3, float t) {
+Line::Curve Line::catmullRom(const vec2f& p0, const vec2f& p1, const vec2f& p2, const vec2f& p3) {
   // See https://en.wikipedia.org/wiki/Centripetal_Catmull%E2%80%93Rom_spline
+  // Same curve as evaluating the pyramid of lerps every time, but turned into a cubic once, through its tangents
+
+  // Knot intervals, kept off 0 so points on top of each other don't divide by it
+  const float d01 = std::max(std::sqrt((p1 - p0).length()), CURVE_MIN_KNOT);
+  const float d12 = std::max(std::sqrt((p2 - p1).length()), CURVE_MIN_KNOT);
+  const float d23 = std::max(std::sqrt((p3 - p2).length()), CURVE_MIN_KNOT);
+
+  // Tangents at P1 and P2, scaled to go from P1 to P2 as t goes from 0 to 1
+  const vec2f m1 = ((p1 - p0) * (1.0f / d01) - (p2 - p0) * (1.0f / (d01 + d12)) + (p2 - p1) * (1.0f / d12)) * d12;
+  const vec2f m2 = ((p2 - p1) * (1.0f / d12) - (p3 - p1) * (1.0f / (d12 + d23)) + (p3 - p2) * (1.0f / d23)) * d12;
+
+  // Hermite basis, scaled up because we're in NDC
+  return {
+    (p1 * 2.0f - p2 * 2.0f + m1 + m2) * 2.0f,
+    (p2 * 3.0f - p1 * 3.0f - m1 * 2.0f - m2) * 2.0f,
+    m1 * 2.0f,
+    p1 * 2.0f
+  };
+}
 
-  // Knot parameters
-  constexpr float t0 = 0.0f;
-  const float t1 = t0 + std::sqrt((p1 - p0).length());
-  const float t2 = t1 + std::sqrt((p2 - p1).length());
-  const float t3 = t2 + std::sqrt((p3 - p2).length());
-
-  // Clamp and rescale t to the range [t1, t2], so it goes from P1 to P2
-  t = t1 + std::clamp(t, 0.0f, 1.0f) * (t2 - t1);
-
-  // Calculate the basis functions
-  const vec2f A1 = p0 * (t1 - t) / (t1 - t0) + p1 * (t - t0) / (t1 - t0);
-  const vec2f A2 = p1 * (t2 - t) / (t2 - t1) + p2 * (t - t1) / (t2 - t1);
-  const vec2f A3 = p2 * (t3 - t) / (t3 - t2) + p3 * (t - t2) / (t3 - t2);
-
-  const vec2f B1 = A1 * (t2 - t) / (t2 - t0) + A2 * (t - t0) / (t2 - t0);
-  const vec2f B2 = A2 * (t3 - t) / (t3 - t1) + A3 * (t - t1) / (t3 - t1);
-
-  return B1 * (t2 - t) / (t2 - t1) + B2 * (t - t1) / (t2 - t1); // Final point
+int Line::Curve::segments(const float tolerance) const {
+  // Segments of a curve stray at most max|P''| / (8 * segments^2) from it, and P'' = 6at + 2b peaks at an end
+  const float curvature = std::max((b * 2.0f).length(), (a * 6.0f + b * 2.0f).length());
+  if (tolerance <= 0.0f) return CURVE_SEGMENTS;
+  const float segments = std::ceil(std::sqrt(curvature / (8.0f * tolerance)));
+  return std::clamp(static_cast<int>(segments), 1, CURVE_SEGMENTS);
 }
@@ -1,55 +1,48 @@
 #ifndef LINE_H
 #define LINE_H
 
-#define CURVE_SEGMENTS 16 // Number of segments to use per curve (higher = smoother, but more expensive)
-
-constexpr float CURVE_STEP = 1.0f / CURVE_SEGMENTS; // Precomputed inverse for efficiency
-
-#include <glad/glad.h>
+#define CURVE_SEGMENTS 16 // Most segments to use per curve (higher = smoother, but more expensive)
+#define CURVE_TOLERANCE 0.0005f // How far a curve may stray from its segments, in NDC when fully zoomed out
+#define CURVE_MIN_KNOT 1e-4f // Smallest knot interval, so points on top of each other don't divide by 0
 
 #include <vector>
+#include <array>
 
 #include "../utils.hpp"
 #include "../error_handler/error_handler.h"
 
+// A smooth line through some points, ending in an arrow, as a triangle strip
+// Only the CPU side of it, give it to a LineBatch to get it drawn
 class Line {
 public:
   float length = 0.0f; // Total length of the line
 
   explicit Line(ErrorHandler* errorHandler) : errorHandler(errorHandler) {}
-  Line(ErrorHandler* errorHandler, const std::vector<vec2f> &points);
-  ~Line() noexcept {
-    // Clean up the mesh data
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-  }
+  // Scale is that of the view the line is meant for, curves get fewer segments the further out it is
+  Line(ErrorHandler* errorHandler, const std::vector<vec2f> &points, float scale = 1.0f);
 
-  //Implement copy constructor
-  Line(const Line& other) {
-    vertices = other.vertices;
-    errorHandler = other.errorHandler;
-    generateMeshData(); // Regenerate the mesh data, otherwise it won't render
-  }
-
-  void render() const;
-  void setPoints(const std::vector<vec2f> &points) {
+  void setPoints(const std::vector<vec2f> &points, const float scale = 1.0f) {
     vertices.clear();
-    generateMesh(points);
-    generateMeshData();
+    generateMesh(points, scale);
   }
+  [[nodiscard]] const std::vector<vec2f>& getVertices() const { return vertices; }
 
 private:
-  unsigned int VAO{}, VBO{};
+  struct Curve { // P(t) = at^3 + bt^2 + ct + d, for t from 0 to 1
+    vec2f a, b, c, d;
+
+    [[nodiscard]] int segments(float tolerance) const; // How many it takes to stay within tolerance of the curve
+  };
+
   std::vector<vec2f> vertices;
 
   ErrorHandler* errorHandler;
 
-  void generateMesh(const std::vector<vec2f> &points);
-  void generateMeshData();
+  void generateMesh(const std::vector<vec2f> &points, float scale);
   void addSegment(const vec2f& start, const vec2f& end, bool final);
 
-  static vec2f catmullRom(const vec2f& p0, const vec2f& p1, const vec2f& p2, const vec2f& p3, float t);
+  static Curve catmullRom(const vec2f& p0, const vec2f& p1, const vec2f& p2, const vec2f& p3);
 };
 
 
-#endif //LINE_H
\ No newline at end of file
+#endif //LINE_H
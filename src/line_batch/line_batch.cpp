@@ -0,0 +1,136 @@
+#include "line_batch.hpp"
+
+LineBatch::~LineBatch() noexcept {
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteBuffers(1, &VBO);
+}
+
+LineBatch::Path LineBatch::add(std::vector<vec2f> points) {
+  Path path;
+  if (!freePaths.empty()) {
+    path = freePaths.back();
+    freePaths.pop_back();
+  } else {
+    path = static_cast<Path>(paths.size());
+    paths.emplace_back();
+  }
+
+  paths[path].used = true;
+  paths[path].points = std::move(points);
+  tessellate(paths[path]);
+  return path;
+}
+
+void LineBatch::set(const Path path, std::vector<vec2f> points) {
+  if (path >= paths.size() || !paths[path].used) return;
+  Range& range = paths[path];
+  wasted += static_cast<size_t>(range.count); // The old one is left behind as a hole
+  range.points = std::move(points);
+  tessellate(range);
+  if (static_cast<float>(wasted) > static_cast<float>(vertices.size()) * LINE_BATCH_COMPACT_RATIO) compact();
+}
+
+void LineBatch::tessellate(Range& range) {
+  // New lines always go at the end, holes only get filled by compacting
+  const Line line(errorHandler, range.points, bucket);
+  const auto& lineVertices = line.getVertices();
+  range.first = static_cast<GLint>(vertices.size());
+  range.count = static_cast<GLsizei>(lineVertices.size());
+  range.length = line.length;
+  dirtyBegin = std::min(dirtyBegin, vertices.size());
+  vertices.insert(vertices.end(), lineVertices.begin(), lineVertices.end());
+  dirtyEnd = vertices.size();
+  drawsDirty = true;
+}
+
+void LineBatch::remove(const Path path) {
+  if (path >= paths.size() || !paths[path].used) return;
+  wasted += static_cast<size_t>(paths[path].count);
+  paths[path] = Range();
+  freePaths.push_back(path);
+  drawsDirty = true;
+  if (static_cast<float>(wasted) > static_cast<float>(vertices.size()) * LINE_BATCH_COMPACT_RATIO) compact();
+}
+
+void LineBatch::clear() {
+  vertices.clear();
+  paths.clear();
+  freePaths.clear();
+  wasted = 0;
+  dirtyBegin = SIZE_MAX;
+  dirtyEnd = 0;
+  drawsDirty = true;
+}
+
+void LineBatch::compact() {
+  // Everything gets copied out of the old buffer, so it doesn't matter that handles aren't in buffer order
+  std::vector<vec2f> compacted;
+  compacted.reserve(vertices.size() - wasted);
+  for (auto& range : paths) {
+    if (!range.used) continue;
+    const auto first = vertices.begin() + range.first;
+    range.first = static_cast<GLint>(compacted.size());
+    compacted.insert(compacted.end(), first, first + range.count);
+  }
+
+  vertices = std::move(compacted);
+  wasted = 0;
+  dirtyBegin = 0;
+  dirtyEnd = vertices.size();
+  drawsDirty = true;
+}
+
+void LineBatch::render(const float scale) {
+  // Tessellated for the closest power of two at or under the zoom, so they're never coarser than they should be
+  if (const float zoom = scale > 0.0f ? std::exp2(std::floor(std::log2(scale))) : 0.0f; zoom != bucket) {
+    bucket = zoom;
+    vertices.clear();
+    wasted = 0;
+    dirtyBegin = SIZE_MAX;
+    dirtyEnd = 0;
+    drawsDirty = true;
+    for (auto& range : paths) if (range.used) tessellate(range);
+  }
+
+  if (VAO == 0) {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(vec2f), nullptr);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+  }
+
+  if (dirtyBegin < dirtyEnd) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    if (vertices.size() > capacity) { // Grow it, and upload everything, since the old contents are gone
+      capacity = std::max(vertices.size(), capacity * 2);
+      glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(vec2f)), nullptr, GL_DYNAMIC_DRAW);
+      dirtyBegin = 0;
+      dirtyEnd = vertices.size();
+    }
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(dirtyBegin * sizeof(vec2f)),
+                    static_cast<GLsizeiptr>((dirtyEnd - dirtyBegin) * sizeof(vec2f)),
+                    vertices.data() + dirtyBegin);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirtyBegin = SIZE_MAX;
+    dirtyEnd = 0;
+  }
+
+  if (drawsDirty) {
+    firsts.clear();
+    counts.clear();
+    for (const auto& range : paths) {
+      if (range.count == 0) continue;
+      firsts.push_back(range.first);
+      counts.push_back(range.count);
+    } drawsDirty = false;
+  }
+
+  if (firsts.empty()) return;
+  glBindVertexArray(VAO);
+  glMultiDrawArrays(GL_TRIANGLE_STRIP, firsts.data(), counts.data(), static_cast<GLsizei>(firsts.size()));
+  glBindVertexArray(0);
+}
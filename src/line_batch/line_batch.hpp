@@ -0,0 +1,67 @@
+#ifndef LINE_BATCH_HPP
+#define LINE_BATCH_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+
+#include "../utils.hpp"
+#include "../line/line.h"
+#include "../error_handler/error_handler.h"
+
+#define LINE_BATCH_COMPACT_RATIO 0.5f // Compact the buffer once this much of it is left over from removed lines
+
+// Every line, like paths or routes, kept in a single vertex buffer and drawn with one call
+// The buffer only grows, lines that get removed leave a hole until there's enough of them to compact it
+// Lines keep their points, so they get tessellated again whenever the zoom goes past a power of two
+class LineBatch {
+public:
+  typedef uint32_t Path; // Handle of a line in the batch, handles of removed lines get reused
+  static constexpr Path NO_PATH = UINT32_MAX;
+
+  explicit LineBatch(ErrorHandler* errorHandler) : errorHandler(errorHandler) {}
+  ~LineBatch() noexcept;
+
+  LineBatch(const LineBatch&) = delete;
+  LineBatch& operator=(const LineBatch&) = delete;
+
+  Path add(std::vector<vec2f> points); // Goes through every point, see Line
+  void set(Path path, std::vector<vec2f> points); // Replaces the line, keeping its handle
+  void remove(Path path);
+  void clear();
+  [[nodiscard]] size_t size() const { return paths.size() - freePaths.size(); }
+  [[nodiscard]] float getLength(const Path path) const { return paths[path].length; }
+
+  // Uploads whatever changed, only call this from the thread that owns the GL context
+  void render(float scale);
+
+private:
+  struct Range {
+    GLint first = 0;
+    GLsizei count = 0; // 0 if removed, or if the line had nothing to draw
+    bool used = false;
+    std::vector<vec2f> points; // What it gets tessellated out of
+    float length = 0.0f;
+  };
+
+  ErrorHandler* errorHandler;
+  float bucket = 1.0f; // Power of two the zoom was at when the lines were tessellated
+  unsigned int VAO{}, VBO{};
+  size_t capacity = 0; // Of the buffer, in vertices
+  std::vector<vec2f> vertices; // CPU copy of the buffer, holes and all
+  std::vector<Range> paths; // Indexed by Path
+  std::vector<Path> freePaths;
+  size_t wasted = 0; // Vertices in holes
+  size_t dirtyBegin = SIZE_MAX, dirtyEnd = 0; // Range of vertices that still have to be uploaded
+  std::vector<GLint> firsts; // What gets drawn, rebuilt only when lines get added or removed
+  std::vector<GLsizei> counts;
+  bool drawsDirty = false;
+
+  void tessellate(Range& range); // At the end of the buffer
+  void compact();
+};
+
+#endif // LINE_BATCH_HPP
@@ -13,6 +13,7 @@
 #include "state_manager/state_manager.hpp"
 #include "error_handler/error_handler.h"
 #include "ticker/ticker.h"
+#include "camera/camera.h"
 
 enum KEYBINDS_ENUM {
 #ifdef DEBUG
@@ -24,7 +25,9 @@ enum KEYBINDS_ENUM {
     MOVE_UP,
     MOVE_DOWN,
     MOVE_LEFT,
-    MOVE_RIGHT
+    MOVE_RIGHT,
+    TOGGLE_RENDERER,
+    NEXT_MAP_MODE
 };
 
 enum MOUSE_KEYBINDS_ENUM {
@@ -46,7 +49,9 @@ static std::unordered_map<KEYBINDS_ENUM, std::vector<std::vector<int>>> keybinds
     {MOVE_UP, {{GLFW_KEY_W}, {GLFW_KEY_UP}}},
     {MOVE_DOWN, {{GLFW_KEY_S}, {GLFW_KEY_DOWN}}},
     {MOVE_LEFT, {{GLFW_KEY_A}, {GLFW_KEY_LEFT}}},
-    {MOVE_RIGHT, {{GLFW_KEY_D}, {GLFW_KEY_RIGHT}}}
+    {MOVE_RIGHT, {{GLFW_KEY_D}, {GLFW_KEY_RIGHT}}},
+    {TOGGLE_RENDERER, {{GLFW_KEY_R}}},
+    {NEXT_MAP_MODE, {{GLFW_KEY_M}}}
 };
 
 static std::unordered_map<MOUSE_KEYBINDS_ENUM, std::vector<std::vector<int>>> mouseKeybinds = {
@@ -98,6 +103,8 @@ bool mouseButtonReleased(GLFWwindow* window, const MOUSE_KEYBINDS_ENUM button) {
 #ifdef DEBUG
 bool tickButtonPressed = false;
 #endif
+bool rendererButtonPressed = false;
+bool mapModeButtonPressed = false;
 void processInput(GLFWwindow* window) {
 #ifdef DEBUG // Debug keybinds
     if (keyPressed(window, DEBUG_WIREFRAME_ON)) glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -116,6 +123,23 @@ void processInput(GLFWwindow* window) {
     if (keyPressed(window, MOVE_DOWN)) offset.y -= scale * 0.001f;
     if (keyPressed(window, MOVE_LEFT)) offset.x -= scale * 0.001f;
     if (keyPressed(window, MOVE_RIGHT)) offset.x += scale * 0.001f;
+
+    // Switch in between the province ID texture and the province meshes, debounced just like ticking
+    if (keyPressed(window, TOGGLE_RENDERER) && !rendererButtonPressed) {
+        const auto *sm = static_cast<StateManager *>(glfwGetWindowUserPointer(window));
+        sm->pm->toggleRenderer();
+        errorHandler.logDebug(sm->pm->isRasterRender() ? "Rendering the map from the province ID texture" :
+                                                         "Rendering the map from the province meshes");
+    } rendererButtonPressed = keyPressed(window, TOGGLE_RENDERER);
+
+    // Go through the map modes, one at a time
+    if (keyPressed(window, NEXT_MAP_MODE) && !mapModeButtonPressed) {
+        const auto *sm = static_cast<StateManager *>(glfwGetWindowUserPointer(window));
+        const auto mode = static_cast<ProvinceManager::MapMode>((sm->pm->getMapMode() + 1) %
+                                                                ProvinceManager::MAP_MODE_COUNT);
+        sm->pm->setMapMode(mode);
+        errorHandler.logDebug("Switched to the " + ProvinceManager::getMapModeName(mode) + " map mode");
+    } mapModeButtonPressed = keyPressed(window, NEXT_MAP_MODE);
 }
 
 std::string selectedProv; // Currently selected province
@@ -133,7 +157,6 @@ void mouse_click_callback(GLFWwindow* window,
     const auto *sm = static_cast<StateManager *>(glfwGetWindowUserPointer(window));
     if (const std::string state = sm->clickedOnState(f); !state.empty()) {
         const std::string provinceName = sm->pm->clickedOnProvince(f);
-        const Province p = sm->pm->getProvince(provinceName);
         errorHandler.logDebug("Clicked on province: " + provinceName + ", on state: " + state);
 
 #ifdef DEBUG
@@ -188,6 +211,7 @@ int main() {
     const Window window(800, 600, "Caesar Engine", &errorHandler);
 
     StateManager sm(&errorHandler);
+    errorHandler.logDebug("Loaded every shader in " + std::to_string(Shader::getTotalLoadTime()) + "ms");
     ticker.registerTickCallback([&sm] { sm.tick(); });
 
     glfwSwapInterval(0); // Disable VSync
@@ -200,6 +224,14 @@ int main() {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    // Every shader gets the camera from here, so scale and offset never have to be set on them one by one
+    Camera camera;
+
+    const Shader& textShader = sm.pm->textShader;
+    const Shader::Uniform textAlpha = textShader.getUniform("alpha"); // Set every frame, so looked up only once
+    textShader.use();
+    textShader.setInt("tex", 0);
+
     //double lastFrame = 0.0;
     while (!window.shouldClose()) {
         //const double time = glfwGetTime();
@@ -210,19 +242,9 @@ int main() {
         processInput(window.window());
 
         // Setup shaders
-        sm.pm->provShader.use();
-        sm.pm->provShader.setFloat("scale", scale);
-        sm.pm->provShader.setVec2f("offset", offset);
-
-        sm.pm->textShader.use();
-        sm.pm->textShader.setFloat("scale", scale);
-        sm.pm->textShader.setVec2f("offset", offset);
-        sm.pm->textShader.setInt("tex", 0);
-        sm.pm->textShader.setFloat("alpha", scale < 0.5f ? scale + 0.5f : 1.0f);
-
-        sm.pm->lineShader.use();
-        sm.pm->lineShader.setFloat("scale", scale);
-        sm.pm->lineShader.setVec2f("offset", offset);
+        camera.update(scale, offset);
+        textShader.use();
+        textShader.setFloat(textAlpha, scale < 0.5f ? scale + 0.5f : 1.0f);
 
         // Render states (and therefore provinces)
         sm.render(window, scale, offset);
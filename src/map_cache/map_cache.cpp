@@ -0,0 +1,226 @@
+#include "map_cache.hpp"
+#include "../polygon/polygon.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file, memory mapped where we can, and read into memory otherwise
+class MappedFile {
+public:
+  explicit MappedFile(const std::string& path) {
+#ifndef _WIN32
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info{};
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+      void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        bytes = static_cast<const unsigned char*>(mapped);
+        length = static_cast<size_t>(info.st_size);
+      }
+    } close(fd); // The mapping stays valid after closing
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return;
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()))) return;
+    bytes = buffer.data();
+    length = buffer.size();
+#endif
+  }
+  ~MappedFile() {
+#ifndef _WIN32
+    if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] const unsigned char* data() const { return bytes; }
+  [[nodiscard]] size_t size() const { return length; }
+
+private:
+  const unsigned char* bytes = nullptr;
+  size_t length = 0;
+#ifdef _WIN32
+  std::vector<unsigned char> buffer;
+#endif
+};
+
+// Bounds checked reads from the cache, since we can't trust anything in it until we've parsed it
+struct Reader {
+  const unsigned char* data;
+  size_t size, offset = 0;
+
+  template <typename T>
+  bool read(T* out, const size_t count = 1) {
+    if (count > (size - offset) / sizeof(T)) return false;
+    std::memcpy(out, data + offset, count * sizeof(T)); // Nothing in there is guaranteed to be aligned
+    offset += count * sizeof(T);
+    return true;
+  }
+};
+
+struct Writer {
+  std::vector<unsigned char> data;
+
+  template <typename T>
+  void write(const T* in, const size_t count = 1) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(in);
+    data.insert(data.end(), bytes, bytes + count * sizeof(T));
+  }
+};
+
+uint64_t MapCache::key(const std::string& mapPath, const std::string& provPath) {
+  // Anything that changes the baked meshes has to go in here
+  const struct {
+    uint32_t version = MAP_CACHE_VERSION;
+    uint32_t merge = PROVINCE_MESH_MERGE;
+    uint32_t contours = PROVINCE_MESH_CONTOURS;
+    float tolerance = PROVINCE_CONTOUR_TOLERANCE;
+    float saddleNudge = SADDLE_NUDGE;
+    uint32_t lodLevels = PROVINCE_LOD_LEVELS;
+  } options;
+  return hashFile(provPath, hashFile(mapPath, fnv1a(&options, sizeof(options))));
+}
+
+std::optional<MapCache::Contents> MapCache::load(const uint64_t key, const size_t provinceCount) const {
+  if (path.empty()) return std::nullopt;
+  const MappedFile file(path);
+  if (!file.data()) {
+    errorHandler->logDebug("No map cache at \"" + path + "\", building it");
+    return std::nullopt;
+  }
+
+  const auto corrupt = [&] {
+    errorHandler->logWarning("Map cache at \"" + path + "\" is corrupt, rebuilding it",
+      ErrorHandler::FILE_NOT_SUCCESSFULLY_READ_ERROR);
+    return std::nullopt;
+  };
+
+  Reader reader{ file.data(), file.size() };
+  Header header{};
+  if (!reader.read(&header)) return corrupt();
+  if (std::memcmp(header.magic, "CMAP", 4) != 0 || header.version != MAP_CACHE_VERSION) {
+    errorHandler->logDebug("Map cache at \"" + path + "\" is from another version, rebuilding it");
+    return std::nullopt;
+  }
+  if (header.key != key || header.provinceCount != provinceCount) {
+    errorHandler->logDebug("Map cache at \"" + path + "\" is stale, rebuilding it");
+    return std::nullopt;
+  }
+  if (header.payloadSize != reader.size - reader.offset ||
+      header.payloadHash != fnv1a(reader.data + reader.offset, header.payloadSize)) return corrupt();
+
+  const auto readMesh = [&](std::vector<Province::Vertex>& vertices, std::vector<unsigned int>& indices) {
+    uint64_t counts[2]; // Vertices and indices
+    if (!reader.read(counts, 2)) return false;
+
+    // Sizes are checked against what's left before allocating anything
+    if (counts[0] > reader.size / sizeof(Province::Vertex) || counts[1] > reader.size / sizeof(unsigned int))
+      return false;
+    vertices.resize(static_cast<size_t>(counts[0]));
+    indices.resize(static_cast<size_t>(counts[1]));
+    if (!reader.read(vertices.data(), vertices.size()) || !reader.read(indices.data(), indices.size()))
+      return false;
+    return std::ranges::none_of(indices, [&](const unsigned int i) { return i >= vertices.size(); });
+  };
+
+  Contents contents;
+  contents.provinces.resize(provinceCount);
+  for (auto& [vertices, indices, lods, center, area] : contents.provinces) {
+    float centerXY[2];
+    uint64_t pixels;
+    if (!reader.read(centerXY, 2) || !reader.read(&pixels) || !readMesh(vertices, indices)) return corrupt();
+    center = vec2f(centerXY[0], centerXY[1]);
+    area = static_cast<size_t>(pixels);
+
+    lods.resize(PROVINCE_LOD_LEVELS - 1);
+    for (auto& lod : lods) if (!readMesh(lod.vertices, lod.indices)) return corrupt();
+  }
+
+  int32_t dimensions[2];
+  if (!reader.read(dimensions, 2) || dimensions[0] < 0 || dimensions[1] < 0) return corrupt();
+  const auto pixels = static_cast<uint64_t>(dimensions[0]) * static_cast<uint64_t>(dimensions[1]);
+  if (pixels > reader.size / sizeof(uint16_t)) return corrupt();
+  std::vector<uint16_t> ids(static_cast<size_t>(pixels));
+  if (!reader.read(ids.data(), ids.size()) || reader.offset != reader.size) return corrupt();
+  if (std::ranges::any_of(ids, [&](const uint16_t id) { return id != ProvinceRaster::NONE && id >= provinceCount; }))
+    return corrupt();
+  contents.raster = ProvinceRaster(vec2i(dimensions[0], dimensions[1]), std::move(ids));
+
+  errorHandler->logDebug("Loaded map cache from \"" + path + "\"");
+  return contents;
+}
+
+void MapCache::save(const uint64_t key, const Contents& contents) const {
+  if (path.empty()) return;
+
+  Writer payload;
+  const auto writeMesh = [&](const std::vector<Province::Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    const uint64_t counts[2] = { vertices.size(), indices.size() };
+    payload.write(counts, 2);
+    payload.write(vertices.data(), vertices.size());
+    payload.write(indices.data(), indices.size());
+  };
+  for (const auto& [vertices, indices, lods, center, area] : contents.provinces) {
+    const float centerXY[2] = { center.x, center.y };
+    const uint64_t pixels = area;
+    payload.write(centerXY, 2);
+    payload.write(&pixels);
+    writeMesh(vertices, indices);
+    for (const auto& lod : lods) writeMesh(lod.vertices, lod.indices);
+  }
+  const int32_t dimensions[2] = { contents.raster.getDimensions().x, contents.raster.getDimensions().y };
+  payload.write(dimensions, 2);
+  payload.write(contents.raster.getIds().data(), contents.raster.getIds().size());
+
+  Header header{};
+  std::memcpy(header.magic, "CMAP", 4);
+  header.version = MAP_CACHE_VERSION;
+  header.key = key;
+  header.provinceCount = contents.provinces.size();
+  header.payloadSize = payload.data.size();
+  header.payloadHash = fnv1a(payload.data.data(), payload.data.size());
+
+  // Write it somewhere else first, so a crash halfway through never leaves a broken cache behind
+  std::error_code error;
+  if (const auto parent = std::filesystem::path(path).parent_path(); !parent.empty())
+    std::filesystem::create_directories(parent, error);
+  const std::string tempPath = path + ".tmp";
+  std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    errorHandler->logWarning("Could not write map cache to \"" + path + "\"", ErrorHandler::COULD_NOT_OPEN_FILE_ERROR);
+    return;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(payload.data.data()), static_cast<std::streamsize>(payload.data.size()));
+  file.close();
+  if (!file) {
+    errorHandler->logWarning("Could not write map cache to \"" + path + "\"", ErrorHandler::COULD_NOT_OPEN_FILE_ERROR);
+    std::filesystem::remove(tempPath, error);
+    return;
+  }
+  std::filesystem::rename(tempPath, path, error);
+  if (error) errorHandler->logWarning("Could not write map cache to \"" + path + "\"",
+    ErrorHandler::COULD_NOT_OPEN_FILE_ERROR);
+  else errorHandler->logDebug("Saved map cache to \"" + path + "\"");
+}
+
+uint64_t MapCache::hashFile(const std::string& path, uint64_t hash) {
+  const MappedFile file(path);
+  if (!file.data()) return hash; // Whoever reads the file will complain about it
+  hash = fnv1a(file.data(), file.size(), hash);
+  const uint64_t size = file.size(); // So an empty file doesn't hash the same as a missing one
+  return fnv1a(&size, sizeof(size), hash);
+}
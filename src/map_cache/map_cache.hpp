@@ -0,0 +1,55 @@
+#ifndef MAP_CACHE_HPP
+#define MAP_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+#include "../utils.hpp"
+#include "../province/province.hpp"
+#include "../province_raster/province_raster.h"
+#include "../error_handler/error_handler.h"
+
+#define MAP_CACHE_VERSION 4 // Bump whenever the layout of the cache, or what goes into it, changes
+
+// Binary cache of everything we bake out of the map, so we don't have to decode it on every launch
+// It's keyed by a hash of whatever it was baked from, so it gets rebuilt whenever any of that changes
+class MapCache {
+public:
+  struct Contents {
+    std::vector<Province::Baked> provinces; // In the same order as the province file
+    ProvinceRaster raster;
+  };
+
+  // An empty path disables the cache altogether
+  MapCache(ErrorHandler* errorHandler, std::string path) : path(std::move(path)), errorHandler(errorHandler) {}
+  ~MapCache() = default;
+
+  MapCache(const MapCache&) = delete;
+  MapCache& operator=(const MapCache&) = delete;
+
+  // Hash of the given files, and every option that changes what we bake out of them
+  [[nodiscard]] static uint64_t key(const std::string& mapPath, const std::string& provPath);
+
+  // Nothing if there's no cache, or if it's stale or corrupt, in which case it should be rebuilt
+  [[nodiscard]] std::optional<Contents> load(uint64_t key, size_t provinceCount) const;
+  void save(uint64_t key, const Contents& contents) const;
+
+private:
+  struct Header {
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint64_t provinceCount;
+    uint64_t payloadSize;
+    uint64_t payloadHash;
+  };
+
+  std::string path;
+  ErrorHandler* errorHandler;
+
+  [[nodiscard]] static uint64_t hashFile(const std::string& path, uint64_t hash);
+};
+
+#endif // MAP_CACHE_HPP
@@ -0,0 +1,63 @@
+#include "map_renderer.hpp"
+
+#include <string>
+
+MapRenderer::~MapRenderer() noexcept {
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteTextures(1, &idTexture);
+}
+
+bool MapRenderer::build(const ProvinceRaster& raster, const size_t provinceCount) {
+  // Sized even if the map can't be drawn this way, since owners keep getting set no matter what draws the map
+  owners.resize(provinceCount, UINT32_MAX); // Nobody's, until told otherwise
+
+  const vec2i dimensions = raster.getDimensions();
+  if (raster.empty()) {
+    errorHandler->logWarning("Map has no pixels to put in a texture, falling back to province meshes",
+      ErrorHandler::FORMAT_ERROR);
+    return false;
+  }
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  if (dimensions.x > maxSize || dimensions.y > maxSize) {
+    errorHandler->logWarning("Map is too big for a single texture (" + std::to_string(dimensions.x) + "x" +
+      std::to_string(dimensions.y) + ", max " + std::to_string(maxSize) + "), falling back to province meshes",
+      ErrorHandler::UNKNOWN_ERROR);
+    return false;
+  }
+
+  if (VAO == 0) {
+    glGenVertexArrays(1, &VAO); // Core profile needs one bound, even though the quad comes from gl_VertexID
+    glGenTextures(1, &idTexture);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, idTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); // IDs can't be blended
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 2); // Rows are tightly packed 16-bit IDs
+  glTexImage2D(GL_TEXTURE_2D,
+               0,
+               GL_R16UI,
+               dimensions.x,
+               dimensions.y,
+               0,
+               GL_RED_INTEGER,
+               GL_UNSIGNED_SHORT,
+               raster.getIds().data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return true;
+}
+
+void MapRenderer::render() {
+  if (idTexture == 0) return;
+  owners.bind(PROVINCE_OWNER_UNIT);
+  glActiveTexture(GL_TEXTURE0 + PROVINCE_ID_UNIT);
+  glBindTexture(GL_TEXTURE_2D, idTexture);
+  glBindVertexArray(VAO);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  glBindVertexArray(0);
+  glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,45 @@
+#ifndef MAP_RENDERER_HPP
+#define MAP_RENDERER_HPP
+
+#include <glad/glad.h>
+
+#include "../province_raster/province_raster.h"
+#include "../province_buffer/province_buffer.h"
+#include "../error_handler/error_handler.h"
+
+#define PROVINCE_ID_UNIT 1 // Texture unit of the province ID texture, has to match the map shader
+#define PROVINCE_OWNER_UNIT 2 // Texture unit of the province owners, has to match the map shader
+
+// Borders are found in the fragment shader, so they don't need any geometry, and follow ownership changes for free
+#define PROVINCE_BORDER_WIDTH 1.0f // In screen pixels, 0 to disable them
+#define PROVINCE_BORDER_COLOR 0.0f, 0.0f, 0.0f, 0.35f // RGBA, alpha blends it over the province color
+#define STATE_BORDER_WIDTH 2.5f // In screen pixels, 0 to disable them
+#define STATE_BORDER_COLOR 0.0f, 0.0f, 0.0f, 0.9f // RGBA, alpha blends it over the province color
+
+// Draws the whole map as a single fullscreen quad, looking up the province of every fragment in the raster
+// Costs the same no matter how many provinces, or vertices, the map has, only the resolution matters
+class MapRenderer {
+public:
+  explicit MapRenderer(ErrorHandler* errorHandler) : errorHandler(errorHandler) {}
+  ~MapRenderer() noexcept;
+
+  MapRenderer(const MapRenderer&) = delete;
+  MapRenderer& operator=(const MapRenderer&) = delete;
+
+  // Only call these from the thread that owns the GL context
+  bool build(const ProvinceRaster& raster, size_t provinceCount); // False if the GPU can't fit the map in a texture
+  void render(); // Province colors have to be bound already
+
+  // Whoever owns each province, state borders get drawn in between provinces with different owners
+  void setOwner(const size_t province, const uint32_t owner) { owners.set(province, owner); }
+
+  [[nodiscard]] bool isBuilt() const { return idTexture != 0; }
+
+private:
+  unsigned int VAO{}, idTexture{};
+  ProvinceBuffer owners{GL_R32UI};
+
+  ErrorHandler* errorHandler;
+};
+
+#endif // MAP_RENDERER_HPP
@@ -0,0 +1,146 @@
+#include "pixel_scan.hpp"
+
+#include <bit>
+#include <cstdint>
+
+// SSE2 is always there on x86-64, AVX2 gets checked for at runtime
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define PIXEL_SCAN_X86
+#include <immintrin.h>
+#endif
+
+// Most runs on real maps are only a few pixels long, too short for loading whole blocks to pay off
+#define PIXEL_SCAN_SCALAR_PIXELS 8
+
+static size_t scalarMismatch(const unsigned char* row, size_t from, const size_t to, const unsigned char* color,
+                             const size_t channels) {
+  for (; from < to; from++) {
+    const unsigned char* pixel = row + from * channels;
+    if (pixel[0] != color[0] || pixel[1] != color[1] || pixel[2] != color[2]) return from;
+  } return to;
+}
+
+#ifdef PIXEL_SCAN_X86
+// Opaque version of the color, as a little endian RGBA pixel
+static uint32_t rgbaPattern(const unsigned char* color) {
+  return static_cast<uint32_t>(color[0]) | static_cast<uint32_t>(color[1]) << 8 |
+         static_cast<uint32_t>(color[2]) << 16 | 0xFF000000u;
+}
+
+// Eight bytes of a, b, c, a, b, c, a, b, so every 8 bytes of RGB pixels is one of three rotations of the color
+static int64_t repeat(const unsigned char a, const unsigned char b, const unsigned char c) {
+  const uint64_t abc = static_cast<uint64_t>(a) | static_cast<uint64_t>(b) << 8 | static_cast<uint64_t>(c) << 16;
+  return static_cast<int64_t>(abc | abc << 24 | abc << 48);
+}
+
+static uint32_t equalBytes(const __m128i a, const __m128i b) {
+  return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+}
+
+// 16 RGB pixels take exactly three registers, so the pattern lines up with every block
+static size_t sse2Mismatch3(const unsigned char* row, size_t from, const size_t to, const unsigned char* color,
+                            const size_t channels) {
+  const int64_t rgb = repeat(color[0], color[1], color[2]);
+  const int64_t brg = repeat(color[2], color[0], color[1]);
+  const int64_t gbr = repeat(color[1], color[2], color[0]);
+  const __m128i p0 = _mm_set_epi64x(brg, rgb), p1 = _mm_set_epi64x(rgb, gbr), p2 = _mm_set_epi64x(gbr, brg);
+
+  for (; from + 16 <= to; from += 16) {
+    const unsigned char* block = row + from * 3;
+    const uint64_t equal =
+      static_cast<uint64_t>(equalBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), p0)) |
+      static_cast<uint64_t>(equalBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16)), p1)) << 16 |
+      static_cast<uint64_t>(equalBytes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32)), p2)) << 32;
+    if (equal != 0xFFFFFFFFFFFFull) return from + static_cast<size_t>(std::countr_one(equal)) / 3;
+  } return scalarMismatch(row, from, to, color, channels);
+}
+
+static size_t sse2Mismatch4(const unsigned char* row, size_t from, const size_t to, const unsigned char* color,
+                            const size_t channels) {
+  const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000u)); // Forced opaque, so it never gets compared
+  const __m128i pattern = _mm_set1_epi32(static_cast<int>(rgbaPattern(color)));
+  const auto equalPixels = [&](const unsigned char* block) {
+    const __m128i pixels = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)), alpha);
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi32(pixels, pattern)));
+  };
+
+  for (; from + 16 <= to; from += 16) {
+    const unsigned char* block = row + from * 4;
+    const uint64_t equal = static_cast<uint64_t>(equalPixels(block)) |
+                           static_cast<uint64_t>(equalPixels(block + 16)) << 16 |
+                           static_cast<uint64_t>(equalPixels(block + 32)) << 32 |
+                           static_cast<uint64_t>(equalPixels(block + 48)) << 48;
+    if (~equal != 0) return from + static_cast<size_t>(std::countr_one(equal)) / 4;
+  } return scalarMismatch(row, from, to, color, channels);
+}
+
+// 32 RGB pixels take exactly three registers
+__attribute__((target("avx2")))
+static size_t avx2Mismatch3(const unsigned char* row, size_t from, const size_t to, const unsigned char* color,
+                            const size_t channels) {
+  const int64_t rgb = repeat(color[0], color[1], color[2]);
+  const int64_t brg = repeat(color[2], color[0], color[1]);
+  const int64_t gbr = repeat(color[1], color[2], color[0]);
+  const __m256i p0 = _mm256_set_epi64x(rgb, gbr, brg, rgb);
+  const __m256i p1 = _mm256_set_epi64x(brg, rgb, gbr, brg);
+  const __m256i p2 = _mm256_set_epi64x(gbr, brg, rgb, gbr);
+  const auto equalBytes = [](const unsigned char* block, const __m256i p) __attribute__((target("avx2"))) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(
+      _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), p)));
+  };
+
+  for (; from + 32 <= to; from += 32) {
+    const unsigned char* block = row + from * 3;
+    if (const uint32_t equal = equalBytes(block, p0); equal != UINT32_MAX)
+      return from + static_cast<size_t>(std::countr_one(equal)) / 3;
+    if (const uint32_t equal = equalBytes(block + 32, p1); equal != UINT32_MAX)
+      return from + static_cast<size_t>(32 + std::countr_one(equal)) / 3;
+    if (const uint32_t equal = equalBytes(block + 64, p2); equal != UINT32_MAX)
+      return from + static_cast<size_t>(64 + std::countr_one(equal)) / 3;
+  } return sse2Mismatch3(row, from, to, color, channels);
+}
+
+__attribute__((target("avx2")))
+static size_t avx2Mismatch4(const unsigned char* row, size_t from, const size_t to, const unsigned char* color,
+                            const size_t channels) {
+  const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+  const __m256i pattern = _mm256_set1_epi32(static_cast<int>(rgbaPattern(color)));
+  const auto equalPixels = [&](const unsigned char* block) __attribute__((target("avx2"))) {
+    const __m256i pixels = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(block)), alpha);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(pixels, pattern)));
+  };
+
+  for (; from + 16 <= to; from += 16) {
+    const unsigned char* block = row + from * 4;
+    const uint64_t equal = static_cast<uint64_t>(equalPixels(block)) |
+                           static_cast<uint64_t>(equalPixels(block + 32)) << 32;
+    if (~equal != 0) return from + static_cast<size_t>(std::countr_one(equal)) / 4;
+  } return sse2Mismatch4(row, from, to, color, channels);
+}
+
+// Checks the first few pixels one by one, and only goes wide once the run turns out to be a long one
+template <size_t (*wideMismatch)(const unsigned char*, size_t, size_t, const unsigned char*, size_t)>
+static size_t shortRunFirst(const unsigned char* row, const size_t from, const size_t to, const unsigned char* color,
+                            const size_t channels) {
+  const size_t prefixEnd = from + PIXEL_SCAN_SCALAR_PIXELS < to ? from + PIXEL_SCAN_SCALAR_PIXELS : to;
+  const size_t end = scalarMismatch(row, from, prefixEnd, color, channels);
+  return end < prefixEnd ? end : wideMismatch(row, end, to, color, channels);
+}
+#endif
+
+PixelScan::PixelScan(const size_t channels, const Level maxLevel) :
+channels(channels), kernel(scalarMismatch), kernelName("scalar") {
+#ifdef PIXEL_SCAN_X86
+  if ((channels != 3 && channels != 4) || maxLevel == SCALAR) return;
+  __builtin_cpu_init();
+  if (maxLevel >= AVX2 && __builtin_cpu_supports("avx2")) {
+    kernel = channels == 3 ? shortRunFirst<avx2Mismatch3> : shortRunFirst<avx2Mismatch4>;
+    kernelName = "AVX2";
+    level = AVX2;
+  } else {
+    kernel = channels == 3 ? shortRunFirst<sse2Mismatch3> : shortRunFirst<sse2Mismatch4>;
+    kernelName = "SSE2";
+    level = SSE2;
+  }
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef PIXEL_SCAN_HPP
+#define PIXEL_SCAN_HPP
+
+#include <cstddef>
+#include <string>
+
+// Finds where runs of same colored pixels end, many pixels at a time where the CPU lets us
+// Only the first three channels are compared, so alpha never splits a run
+class PixelScan {
+public:
+  enum Level { // Kernels, from slowest to fastest
+    SCALAR,
+    SSE2,
+    AVX2
+  };
+
+  // The kernel is picked once, from the number of channels and what the CPU supports, up to the given level
+  explicit PixelScan(size_t channels, Level maxLevel = AVX2);
+  ~PixelScan() = default;
+
+  // First pixel in [from, to) of the given row that isn't the same color as color, or to if there's none
+  [[nodiscard]] size_t mismatch(const unsigned char* row, const size_t from, const size_t to,
+                                const unsigned char* color) const {
+    return kernel(row, from, to, color, channels);
+  }
+
+  [[nodiscard]] std::string getKernelName() const { return kernelName; }
+  [[nodiscard]] Level getLevel() const { return level; }
+
+private:
+  using Kernel = size_t (*)(const unsigned char* row, size_t from, size_t to, const unsigned char* color,
+                            size_t channels);
+
+  size_t channels;
+  Kernel kernel;
+  std::string kernelName;
+  Level level = SCALAR;
+};
+
+#endif // PIXEL_SCAN_HPP
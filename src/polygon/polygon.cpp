@@ -0,0 +1,338 @@
+#include "polygon.hpp"
+
+std::vector<Polygon> Polygon::trace(const std::vector<Province::Run>& runs) {
+  if (runs.empty()) return {};
+
+  // Rasterize the runs into a mask with an empty border, so we never have to check bounds
+  int minX = std::numeric_limits<int>::max(), minY = minX, maxX = std::numeric_limits<int>::min(), maxY = maxX;
+  for (const auto& [row, start, end] : runs) {
+    minX = std::min(minX, start);
+    maxX = std::max(maxX, end);
+    minY = std::min(minY, row);
+    maxY = std::max(maxY, row + 1);
+  }
+  const int width = maxX - minX + 2, height = maxY - minY + 2;
+  std::vector<unsigned char> mask(static_cast<size_t>(width) * static_cast<size_t>(height), 0);
+  const auto inside = [&](const int x, const int y) { return mask[static_cast<size_t>(y * width + x)] != 0; };
+  for (const auto& [row, start, end] : runs) {
+    for (int x = start; x < end; x++) mask[static_cast<size_t>((row - minY + 1) * width + x - minX + 1)] = 1;
+  }
+
+  // Directed edges in between pixel corners, with the inside of the shape on their left
+  struct Edge { int x, y, dx, dy; }; // Starting corner and direction
+  std::vector<Edge> edges;
+  for (int y = 1; y < height - 1; y++) {
+    for (int x = 1; x < width - 1; x++) {
+      if (!inside(x, y)) continue;
+      if (!inside(x, y - 1)) edges.push_back({ x, y, 1, 0 });
+      if (!inside(x + 1, y)) edges.push_back({ x + 1, y, 0, 1 });
+      if (!inside(x, y + 1)) edges.push_back({ x + 1, y + 1, -1, 0 });
+      if (!inside(x - 1, y)) edges.push_back({ x, y + 1, 0, -1 });
+    }
+  }
+  const auto corner = [&](const int x, const int y) { return y * (width + 1) + x; };
+  std::ranges::sort(edges, {}, [&](const Edge& e) { return corner(e.x, e.y); });
+
+  // Walk the edges into rings
+  std::vector<std::vector<vec2f>> rings;
+  std::vector<bool> used(edges.size(), false);
+  const vec2f origin(static_cast<float>(minX - 1), static_cast<float>(minY - 1));
+  for (size_t first = 0; first < edges.size(); first++) {
+    if (used[first]) continue;
+    std::vector<vec2f> ring;
+    for (size_t e = first;;) {
+      used[e] = true;
+      const auto [x, y, dx, dy] = edges[e];
+      const int key = corner(x + dx, y + dy);
+      auto next = static_cast<size_t>(std::ranges::lower_bound(edges, key, {}, [&](const Edge& edge) {
+        return corner(edge.x, edge.y);
+      }) - edges.begin());
+
+      // Where two rings touch diagonally, we keep going around the same pixel, and pull
+      // that corner slightly towards it, so rings never share a single point
+      const bool saddle = next + 1 < edges.size() && corner(edges[next + 1].x, edges[next + 1].y) == key;
+      if (saddle && (edges[next].dx != -dy || edges[next].dy != dx)) next++;
+
+      if (saddle || edges[next].dx != dx || edges[next].dy != dy) { // Only keep the corners we turn on
+        vec2f point(static_cast<float>(x + dx), static_cast<float>(y + dy));
+        if (saddle) point += vec2f(static_cast<float>(edges[next].dx - dx), static_cast<float>(edges[next].dy - dy)) *
+          SADDLE_NUDGE;
+        ring.push_back(point + origin);
+      }
+
+      if (next == first) break;
+      if (used[next]) { // Should never happen, but we'd rather lose a ring than loop forever
+        ring.clear();
+        break;
+      } e = next;
+    } if (ring.size() >= 3) rings.push_back(std::move(ring));
+  }
+
+  // Outlines go one way, holes go the other, so sort them out
+  std::vector<Polygon> polygons;
+  std::vector<double> areas;
+  std::vector<std::vector<vec2f>> holes;
+  for (auto& ring : rings) {
+    if (const double area = signedArea(ring); area > 0.0) {
+      polygons.push_back({ std::move(ring), {} });
+      areas.push_back(area);
+    } else holes.push_back(std::move(ring));
+  }
+
+  // Every hole belongs to the smallest outline around it
+  for (auto& hole : holes) {
+    size_t best = polygons.size();
+    for (size_t i = 0; i < polygons.size(); i++) {
+      if (!contains(polygons[i].outline, hole[0])) continue;
+      if (best == polygons.size() || areas[i] < areas[best]) best = i;
+    } if (best < polygons.size()) polygons[best].holes.push_back(std::move(hole));
+  } return polygons;
+}
+
+void Polygon::simplify(const float tolerance) {
+  if (tolerance <= 0.0f) return;
+  Polygon simplified{ simplifyRing(outline, tolerance), {} };
+  for (const auto& hole : holes) simplified.holes.push_back(simplifyRing(hole, tolerance));
+
+  // Rings that would collapse, or flip, are kept as they were
+  if (simplified.outline.size() < 3 || signedArea(simplified.outline) <= 0.0) simplified.outline = outline;
+  for (size_t i = 0; i < holes.size(); i++) {
+    if (simplified.holes[i].size() < 3 || signedArea(simplified.holes[i]) >= 0.0) simplified.holes[i] = holes[i];
+  }
+
+  if (!simplified.selfIntersects()) *this = std::move(simplified);
+}
+
+bool Polygon::triangulate(std::vector<vec2f>& vertices, std::vector<unsigned int>& indices) const {
+  // Cut every hole into the outline, from the rightmost one to the leftmost one
+  std::vector<vec2f> points = outline;
+  std::vector<const std::vector<vec2f>*> sortedHoles;
+  for (const auto& hole : holes) sortedHoles.push_back(&hole);
+  std::ranges::sort(sortedHoles, std::greater{}, [](const std::vector<vec2f>* hole) {
+    return std::ranges::max(*hole, {}, &vec2f::x).x;
+  });
+  for (const auto* hole : sortedHoles) if (!bridge(points, *hole)) return false;
+
+  const size_t n = points.size();
+  if (n < 3) return false;
+  std::vector<size_t> prev(n), next(n);
+  for (size_t i = 0; i < n; i++) {
+    prev[i] = (i + n - 1) % n;
+    next[i] = (i + 1) % n;
+  }
+
+  const auto base = static_cast<unsigned int>(vertices.size());
+  const size_t indexCount = indices.size();
+  const auto unlink = [&](const size_t i) {
+    next[prev[i]] = next[i];
+    prev[next[i]] = prev[i];
+  };
+  const auto isEar = [&](const size_t a, const size_t b, const size_t c) {
+    if (cross(points[a], points[b], points[c]) <= 0.0) return false; // Reflex, or degenerate
+    for (size_t p = next[c]; p != a; p = next[p]) {
+      const vec2f& v = points[p];
+      if (v == points[a] || v == points[b] || v == points[c]) continue; // Duplicated by a bridge
+      if (cross(points[a], points[b], v) >= 0.0 &&
+          cross(points[b], points[c], v) >= 0.0 &&
+          cross(points[c], points[a], v) >= 0.0) return false;
+    } return true;
+  };
+
+  size_t i = 0;
+  for (size_t remaining = n, stalled = 0; remaining > 3;) {
+    if (isEar(prev[i], i, next[i])) {
+      indices.insert(indices.end(), {
+        base + static_cast<unsigned int>(prev[i]),
+        base + static_cast<unsigned int>(i),
+        base + static_cast<unsigned int>(next[i])
+      });
+      unlink(i);
+      i = next[i];
+      remaining--;
+      stalled = 0;
+      continue;
+    }
+
+    i = next[i];
+    if (++stalled <= remaining) continue;
+
+    // We went all the way around without finding an ear, so get rid of any
+    // flat corner that might be blocking us, or give up if there isn't any
+    size_t flat = i;
+    do {
+      if (cross(points[prev[flat]], points[flat], points[next[flat]]) == 0.0) break;
+      flat = next[flat];
+    } while (flat != i);
+    if (cross(points[prev[flat]], points[flat], points[next[flat]]) != 0.0) {
+      indices.resize(indexCount);
+      return false;
+    }
+    i = next[flat];
+    unlink(flat);
+    remaining--;
+    stalled = 0;
+  }
+  indices.insert(indices.end(), {
+    base + static_cast<unsigned int>(prev[i]),
+    base + static_cast<unsigned int>(i),
+    base + static_cast<unsigned int>(next[i])
+  });
+
+  vertices.insert(vertices.end(), points.begin(), points.end());
+  return true;
+}
+
+double Polygon::signedArea(const std::vector<vec2f>& ring) {
+  double area = 0.0;
+  for (size_t i = 1; i + 1 < ring.size(); i++) area += cross(ring[0], ring[i], ring[i + 1]);
+  return area * 0.5;
+}
+
+bool Polygon::contains(const std::vector<vec2f>& ring, const vec2f& point) {
+  bool inside = false;
+  for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+    if ((ring[i].y > point.y) == (ring[j].y > point.y)) continue;
+    if (point.x < (ring[j].x - ring[i].x) * (point.y - ring[i].y) / (ring[j].y - ring[i].y) + ring[i].x)
+      inside = !inside;
+  } return inside;
+}
+
+std::vector<vec2f> Polygon::simplifyRing(const std::vector<vec2f>& ring, const float tolerance) {
+  if (ring.size() <= 4) return ring;
+
+  // Split the ring at its first point and the one furthest from it, and simplify both halves
+  const size_t n = ring.size();
+  size_t far = 0;
+  for (size_t i = 1; i < n; i++) {
+    if ((ring[i] - ring[0]).length() > (ring[far] - ring[0]).length()) far = i;
+  }
+
+  std::vector<bool> keep(n, false);
+  keep[0] = keep[far] = true;
+  std::vector<std::pair<size_t, size_t>> stack = { { 0, far }, { far, n } }; // Index n wraps back to 0
+  while (!stack.empty()) {
+    const auto [first, last] = stack.back();
+    stack.pop_back();
+    const vec2f& a = ring[first];
+    const vec2f ab = ring[last % n] - a;
+    const float lengthSquared = ab.dot(ab);
+
+    size_t furthest = first;
+    float furthestDistance = tolerance;
+    for (size_t i = first + 1; i < last; i++) {
+      // Distance to the closest point of the segment
+      const vec2f ap = ring[i] - a;
+      const float t = lengthSquared > 0.0f ? std::clamp(ap.dot(ab) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+      const float distance = (ap - ab * t).length();
+      if (distance <= furthestDistance) continue;
+      furthest = i;
+      furthestDistance = distance;
+    } if (furthest == first) continue;
+
+    keep[furthest] = true;
+    stack.emplace_back(first, furthest);
+    stack.emplace_back(furthest, last);
+  }
+
+  std::vector<vec2f> simplified;
+  for (size_t i = 0; i < n; i++) if (keep[i]) simplified.push_back(ring[i]);
+  return simplified;
+}
+
+bool Polygon::bridge(std::vector<vec2f>& ring, const std::vector<vec2f>& hole) {
+  // See https://www.geometrictools.com/Documentation/TriangulationByEarClipping.pdf
+  const size_t m = static_cast<size_t>(std::ranges::max_element(hole, {}, &vec2f::x) - hole.begin());
+  const vec2f& M = hole[m];
+  const size_t n = ring.size();
+
+  // Cast a ray to the right of the hole, and find the closest edge it hits
+  float closest = std::numeric_limits<float>::max();
+  size_t edge = n;
+  for (size_t i = 0; i < n; i++) {
+    const vec2f& a = ring[i];
+    const vec2f& b = ring[(i + 1) % n];
+    if ((a.y > M.y) == (b.y > M.y)) continue;
+    const float x = a.x + (M.y - a.y) * (b.x - a.x) / (b.y - a.y);
+    if (x < M.x || x >= closest) continue;
+    closest = x;
+    edge = i;
+  } if (edge == n) return false;
+
+  // The end of that edge furthest to the right is visible, unless something's in the way
+  const vec2f I(closest, M.y);
+  size_t p = ring[edge].x > ring[(edge + 1) % n].x ? edge : (edge + 1) % n;
+  if (ring[p] != I) {
+    const vec2f P = ring[p];
+    const double sign = cross(M, I, P) > 0.0 ? 1.0 : -1.0;
+    float bestAngle = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < n; i++) {
+      const vec2f& v = ring[i];
+      if (i == p || cross(ring[(i + n - 1) % n], v, ring[(i + 1) % n]) > 0.0) continue; // Only reflex corners
+      if (cross(M, I, v) * sign < 0.0 || cross(I, P, v) * sign < 0.0 || cross(P, M, v) * sign < 0.0) continue;
+      const float angle = std::atan2(std::abs(v.y - M.y), v.x - M.x);
+      if (angle > bestAngle || (angle == bestAngle && (v - M).length() >= (ring[p] - M).length())) continue;
+      bestAngle = angle;
+      p = i;
+    }
+  }
+
+  // If that corner is already shared by another bridge, pick the copy facing the hole
+  for (size_t i = 0; i < n; i++) {
+    if (ring[i] != ring[p]) continue;
+    const vec2f& a = ring[(i + n - 1) % n];
+    const vec2f& b = ring[(i + 1) % n];
+    const bool convex = cross(a, ring[i], b) >= 0.0;
+    const bool afterA = cross(a, ring[i], M) > 0.0, beforeB = cross(ring[i], b, M) > 0.0;
+    if (convex ? afterA && beforeB : afterA || beforeB) {
+      p = i;
+      break;
+    }
+  }
+
+  // Go from the ring to the hole, all the way around it, and back
+  std::vector<vec2f> merged;
+  merged.reserve(n + hole.size() + 2);
+  merged.insert(merged.end(), ring.begin(), ring.begin() + static_cast<long>(p) + 1);
+  for (size_t i = 0; i <= hole.size(); i++) merged.push_back(hole[(m + i) % hole.size()]);
+  merged.push_back(ring[p]);
+  merged.insert(merged.end(), ring.begin() + static_cast<long>(p) + 1, ring.end());
+  ring = std::move(merged);
+  return true;
+}
+
+bool Polygon::selfIntersects() const {
+  std::vector<std::pair<vec2f, vec2f>> segments;
+  std::vector<size_t> ringStarts;
+  const auto addRing = [&](const std::vector<vec2f>& ring) {
+    ringStarts.push_back(segments.size());
+    for (size_t i = 0; i < ring.size(); i++) segments.emplace_back(ring[i], ring[(i + 1) % ring.size()]);
+  };
+  addRing(outline);
+  for (const auto& hole : holes) addRing(hole);
+  ringStarts.push_back(segments.size());
+
+  const auto sign = [](const double v) { return (v > 0.0) - (v < 0.0); };
+  const auto intersects = [&](const std::pair<vec2f, vec2f>& s, const std::pair<vec2f, vec2f>& t) {
+    const int d1 = sign(cross(t.first, t.second, s.first)), d2 = sign(cross(t.first, t.second, s.second));
+    const int d3 = sign(cross(s.first, s.second, t.first)), d4 = sign(cross(s.first, s.second, t.second));
+    if (d1 != d2 && d3 != d4) return true;
+    const auto onSegment = [](const vec2f& a, const vec2f& b, const vec2f& p) {
+      return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x) &&
+             std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+    };
+    return (d1 == 0 && onSegment(t.first, t.second, s.first)) || (d2 == 0 && onSegment(t.first, t.second, s.second)) ||
+           (d3 == 0 && onSegment(s.first, s.second, t.first)) || (d4 == 0 && onSegment(s.first, s.second, t.second));
+  };
+
+  for (size_t r = 0; r + 1 < ringStarts.size(); r++) {
+    const size_t ringSize = ringStarts[r + 1] - ringStarts[r];
+    for (size_t i = ringStarts[r]; i < ringStarts[r + 1]; i++) {
+      for (size_t j = i + 1; j < segments.size(); j++) {
+        // Neighbouring segments of the same ring always share a corner
+        if (j < ringStarts[r + 1] && (j == i + 1 || (i == ringStarts[r] && j == ringStarts[r] + ringSize - 1)))
+          continue;
+        if (intersects(segments[i], segments[j])) return true;
+      }
+    }
+  } return false;
+}
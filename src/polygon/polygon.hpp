@@ -0,0 +1,50 @@
+#ifndef POLYGON_HPP
+#define POLYGON_HPP
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../utils.hpp"
+#include "../province/province.hpp"
+
+#define SADDLE_NUDGE 0.05f // How far, in pixels, rings are pulled apart where they touch diagonally
+
+// Outline of a 4-connected group of pixels, with its holes, in pixel coordinates
+class Polygon {
+public:
+  std::vector<vec2f> outline; // Positive signed area
+  std::vector<std::vector<vec2f>> holes; // Negative signed area
+
+  // Traces the outlines of the given runs, returning one polygon per 4-connected group of pixels
+  [[nodiscard]] static std::vector<Polygon> trace(const std::vector<Province::Run>& runs);
+
+  // Douglas-Peucker simplification of every ring, with the given tolerance in pixels
+  // If the simplified polygon would intersect itself, it's left as it was
+  void simplify(float tolerance);
+
+  // Ear clipping triangulation, appended to the given buffers
+  // Returns false, leaving the buffers untouched, if the polygon couldn't be triangulated
+  [[nodiscard]] bool triangulate(std::vector<vec2f>& vertices, std::vector<unsigned int>& indices) const;
+
+  [[nodiscard]] size_t size() const {
+    size_t size = outline.size();
+    for (const auto& hole : holes) size += hole.size();
+    return size;
+  }
+
+private:
+  // Positive if o -> a -> b turns left, in double precision, since maps can get big enough for floats to round it
+  [[nodiscard]] static double cross(const vec2f& o, const vec2f& a, const vec2f& b) {
+    return static_cast<double>(a.x - o.x) * static_cast<double>(b.y - o.y) -
+           static_cast<double>(a.y - o.y) * static_cast<double>(b.x - o.x);
+  }
+  [[nodiscard]] static double signedArea(const std::vector<vec2f>& ring);
+  [[nodiscard]] static bool contains(const std::vector<vec2f>& ring, const vec2f& point);
+  [[nodiscard]] static std::vector<vec2f> simplifyRing(const std::vector<vec2f>& ring, float tolerance);
+  [[nodiscard]] static bool bridge(std::vector<vec2f>& ring, const std::vector<vec2f>& hole);
+  [[nodiscard]] bool selfIntersects() const;
+};
+
+#endif // POLYGON_HPP
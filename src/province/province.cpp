@@ -1,154 +1,141 @@
 #include "province.hpp"
+#include "../province_map/province_map.hpp"
+#include "../polygon/polygon.hpp"
 
 Province::Province(ErrorHandler* errorHandler,
-                   const char* mapPath,
                    const Color color,
                    std::string name,
                    const City &city,
-                   const std::unordered_set<Color, Color::HashFunction> &usedColors) :
+                   const ProvinceMap &map,
+                   const size_t index) :
 city(city), color(color), name(std::move(name)), errorHandler(errorHandler)  {
-  generateMesh(mapPath, usedColors);
-  generateMeshData();
+  generateMesh(map, index); // Doesn't touch the GPU, so this can be done from any thread
+  generateBounds();
 }
 
-void Province::generateMesh(const char* mapPath, const std::unordered_set<Color, Color::HashFunction>& usedColors) {
-  // If we don't do this, we'll get vertically flipped provinces
-  stbi_set_flip_vertically_on_load(false);
-
-  int x, y, n;
-  unsigned char* data = stbi_load(mapPath, &x, &y, &n, 0);
-  if (!data) errorHandler->logFatal("Failed to load map texture",
-    ErrorHandler::FILE_NOT_SUCCESSFULLY_READ_ERROR);
-  if (x * y * n > std::numeric_limits<int>::max()) {
-    errorHandler->logFatal("Map dimensions too big to handle. Maximum 715827882 pixels allowed!");
-    return;
-  }
-
-  // Even though the theoretical maximum size is more than this, it should NEVER
-  // reach that point, so we can safely use this. Could probably reduce further, but, eh.
-  vertices.reserve(static_cast<size_t>(x * y));
-  indices.reserve(static_cast<size_t>(x * y));
+Province::Province(ErrorHandler* errorHandler,
+                   const Color color,
+                   std::string name,
+                   const City &city,
+                   Baked baked) :
+city(city), vertices(std::move(baked.vertices)), indices(std::move(baked.indices)), lods(std::move(baked.lods)),
+color(color), name(std::move(name)), center(baked.center), area(baked.area), errorHandler(errorHandler) {
+  generateBounds();
+}
 
-  const float x1 = 2.0f / static_cast<float>(x);
-  const float y1 = -2.0f / static_cast<float>(y);
+void Province::generateMesh(const ProvinceMap& map, const size_t index) {
+  const auto& shape = map.getShape(index);
+  area = shape.area;
+  center = shape.center;
+  const vec2i dimensions = map.getDimensions();
 
-  for (int i = 0; i < x * y * n; i += n) {
-    if (data[i] != color.r ||
-        data[i + 1] != color.g ||
-        data[i + 2] != color.b) continue;
+  // Coarser meshes for when we're zoomed out, out of the downsampled map, so they still tile with each other
+  // Tiny provinces can end up without any pixels on them, but by then they'd be smaller than a screen pixel
+  lods.resize(PROVINCE_LOD_LEVELS - 1);
+  for (size_t level = 1; level < PROVINCE_LOD_LEVELS; level++)
+    addRects(mergeRuns(shape.lodRuns[level - 1]), 1 << level, dimensions, lods[level - 1]);
 
-    // Some preliminary calculations we'll use over and over
-    const int xy = i / n;
-    const float p = static_cast<float>(xy % x) * x1 - 1.0f;
-    const float q = static_cast<float>(xy / x) * y1 + 1.0f;
+  if (shape.runs.empty()) {
+    errorHandler->logWarning("Province " + name + " has no pixels on the map", ErrorHandler::FORMAT_ERROR);
+    return;
+  }
 
-    // Start of rectangle adjacency
-    if (i % (n * x) > 0) {
-      if (auto c = Color(data[i - n], data[i - n + 1], data[i - n + 2]);
-          usedColors.contains(c)) adjacentColors.insert(c);
-    }
+  const float x1 = 2.0f / static_cast<float>(dimensions.x);
+  const float y1 = -2.0f / static_cast<float>(dimensions.y);
+
+  if (PROVINCE_MESH_CONTOURS) {
+    if (generateContourMesh(shape.runs, x1, y1)) {
+      errorHandler->logDebug("Vertices: " + std::to_string(vertices.size()) +
+        " (" + std::to_string(4 * shape.runs.size()) + " as scanline quads)");
+      errorHandler->logDebug("Indices: " + std::to_string(indices.size()) +
+        " (" + std::to_string(6 * shape.runs.size()) + " as scanline quads)");
+      return;
+    } errorHandler->logDebug("Could not triangulate province " + name + ", falling back to scanline quads");
+  }
 
-    // Actual quad generation
-    const int i0 = i;
-    float p0 = p;
-    do {
-      p0 += x1;
-      i += n;
-      area++;
-    } while (data[i] == color.r && data[i + 1] == color.g && data[i + 2] == color.b && i % (n * x) != 0);
-
-    // End of rectangle adjacency
-    if (i % (n * x) < n * (x - 1)) {
-      if (auto c = Color(data[i + n], data[i + n + 1], data[i + n + 2]);
-          usedColors.contains(c)) adjacentColors.insert(c);
-    }
+  Mesh mesh;
+  addRects(PROVINCE_MESH_MERGE ? mergeRuns(shape.runs) : toRects(shape.runs), 1, dimensions, mesh);
+  vertices = std::move(mesh.vertices);
+  indices = std::move(mesh.indices);
 
-    // Above rectangle adjacency
-    if (i >= n * x) {
-      for (int j = i0 - n * x; j < i - n * x; j += n) {
-        if (auto c = Color(data[j], data[j + 1], data[j + 2]);
-            usedColors.contains(c)) adjacentColors.insert(c);
-      }
-    }
+  errorHandler->logDebug("Vertices: " + std::to_string(vertices.size()) +
+    " (" + std::to_string(4 * shape.runs.size()) + " before merging)");
+  errorHandler->logDebug("Indices: " + std::to_string(indices.size()) +
+    " (" + std::to_string(6 * shape.runs.size()) + " before merging)");
+}
 
-    // Below rectangle adjacency
-    if (i <= n * x * (y - 1)) {
-      for (int j = i0 + n * x; j < i + n * x; j += n) {
-        if (auto c = Color(data[j], data[j + 1], data[j + 2]);
-            usedColors.contains(c)) adjacentColors.insert(c);
-      }
-    }
+void Province::addRects(const std::vector<Rect>& rects, const int factor, const vec2i dimensions, Mesh& mesh) {
+  const float x1 = 2.0f / static_cast<float>(dimensions.x);
+  const float y1 = -2.0f / static_cast<float>(dimensions.y);
 
-    center += vec2f(p + p0, q + q + y1);
+  // One quad per rectangle, so we know exactly how much we need
+  // Downsampled rectangles are in cells of factor pixels, and the last ones can stick out of the map
+  mesh.vertices.reserve(mesh.vertices.size() + 4 * rects.size());
+  mesh.indices.reserve(mesh.indices.size() + 6 * rects.size());
+  for (const auto& [top, bottom, start, end] : rects) {
+    const float p = static_cast<float>(std::min(start * factor, dimensions.x)) * x1 - 1.0f;
+    const float p0 = static_cast<float>(std::min(end * factor, dimensions.x)) * x1 - 1.0f;
+    const float q = static_cast<float>(std::min(top * factor, dimensions.y)) * y1 + 1.0f;
+    const float q0 = static_cast<float>(std::min(bottom * factor, dimensions.y)) * y1 + 1.0f;
 
     // Add quad
-    const auto index = static_cast<unsigned int>(vertices.size());
+    const auto i = static_cast<unsigned int>(mesh.vertices.size());
 
-    vertices.emplace_back(p, q);
-    vertices.emplace_back(p, q + y1);
-    vertices.emplace_back(p0, q);
-    vertices.emplace_back(p0, q + y1);
+    mesh.vertices.emplace_back(p, q);
+    mesh.vertices.emplace_back(p, q0);
+    mesh.vertices.emplace_back(p0, q);
+    mesh.vertices.emplace_back(p0, q0);
 
-    indices.insert(indices.end(), {
-        index, index + 1, index + 2,
-        index + 3, index + 2, index + 1
+    mesh.indices.insert(mesh.indices.end(), {
+        i, i + 1, i + 2,
+        i + 3, i + 2, i + 1
     });
-  } stbi_image_free(data);
-
-  adjacentColors.erase(color); // Remove the color of the province itself
-
-  // Shrink to fit, so we don't waste any memory
-  // And trust me, it will waste A LOT of memory
-  vertices.shrink_to_fit();
-  indices.shrink_to_fit();
+  }
+}
 
-  errorHandler->logDebug("Vertices: " + std::to_string(vertices.size()));
-  errorHandler->logDebug("Indices: " + std::to_string(indices.size()));
+bool Province::generateContourMesh(const std::vector<Run>& runs, const float x1, const float y1) {
+  std::vector<vec2f> points;
+  std::vector<unsigned int> triangles;
+  for (const auto& polygon : Polygon::trace(runs)) {
+    // Simplifying can leave rings too close to each other to be clipped, so retry without it
+    Polygon simplified = polygon;
+    simplified.simplify(PROVINCE_CONTOUR_TOLERANCE);
+    if (!simplified.triangulate(points, triangles) && !polygon.triangulate(points, triangles)) return false;
+  }
 
-  center /= static_cast<float>(vertices.size());
+  vertices.reserve(points.size());
+  for (const auto& point : points) vertices.emplace_back(point.x * x1 - 1.0f, point.y * y1 + 1.0f);
+  indices = std::move(triangles);
+  return true;
 }
 
-void Province::generateMeshData() {
-  glGenVertexArrays(1, &VAO);
-  glGenBuffers(1, &VBO);
-  glGenBuffers(1, &EBO);
-
-  // Bind VAO
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER,
-               static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)),
-               &vertices[0],
-               GL_STATIC_DRAW);
-
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
-               &indices[0],
-               GL_STATIC_DRAW);
-
-  glVertexAttribPointer(0,
-                        2,
-                        GL_FLOAT,
-                        GL_FALSE,
-                        sizeof(Vertex),
-                        nullptr);
-  glEnableVertexAttribArray(0);
-
-  glBindVertexArray(0);
+std::vector<Province::Rect> Province::toRects(const std::vector<Run>& runs) {
+  std::vector<Rect> rects;
+  rects.reserve(runs.size());
+  for (const auto& [row, start, end] : runs) rects.push_back({ row, row + 1, start, end });
+  return rects;
 }
 
-void Province::render() const {
-  glBindVertexArray(VAO);
-  glDrawElements(GL_TRIANGLES,
-                 static_cast<int>(indices.size()),
-                 GL_UNSIGNED_INT,
-                 nullptr);
-  glBindVertexArray(0);
-}
+std::vector<Province::Rect> Province::mergeRuns(const std::vector<Run>& runs) {
+  // Runs come sorted by row, and then by start, so we only need to walk the rectangles
+  // that reached the previous row alongside the runs of the current one
+  std::vector<Rect> rects;
+  std::vector<size_t> open, nextOpen; // Rectangles that reach the previous/current row, sorted by start
+  size_t o = 0;
+  for (size_t r = 0; r < runs.size(); r++) {
+    const auto& [row, start, end] = runs[r];
+    while (o < open.size() && (rects[open[o]].bottom != row || rects[open[o]].start < start)) o++;
+    if (o < open.size() && rects[open[o]].start == start && rects[open[o]].end == end) {
+      rects[open[o]].bottom++; // Same extent right above us, so just make it taller
+      nextOpen.push_back(open[o++]);
+    } else {
+      nextOpen.push_back(rects.size());
+      rects.push_back({ row, row + 1, start, end });
+    }
 
-bool Province::clickedOn(const float x, const float y) const {
-  return std::ranges::any_of(vertices | std::ranges::views::chunk(4),[&](auto&& rect) {
-    return x >= rect[0].x && x <= rect[3].x && y >= rect[3].y && y <= rect[0].y;
-  });
+    if (r + 1 < runs.size() && runs[r + 1].row == row) continue;
+    std::swap(open, nextOpen); // Last run of this row
+    nextOpen.clear();
+    o = 0;
+  } return rects;
 }
@@ -15,6 +15,16 @@
 #include "../utils.hpp"
 #include "../error_handler/error_handler.h"
 
+#define PROVINCE_MESH_MERGE true // Merge runs that line up vertically into taller quads (false = one quad per run)
+#define PROVINCE_MESH_CONTOURS false // Trace and triangulate province outlines, instead of using scanline quads
+#define PROVINCE_CONTOUR_TOLERANCE 1.0f // How far, in pixels, simplified outlines can stray from the real ones
+#define PROVINCE_LOD_LEVELS 4 // Meshes per province, every level is built out of a map downsampled twice as much
+
+class ProvinceMap;
+
+typedef uint32_t ProvinceId; // Dense handle of a province, its position in the province file
+constexpr ProvinceId NO_PROVINCE = UINT32_MAX;
+
 class Province {
 public:
   struct Color {
@@ -33,13 +43,10 @@ public:
     // For unordered_set
     bool operator==(const Color& other) const { return r == other.r && g == other.g && b == other.b; }
 
+    [[nodiscard]] uint32_t packed() const { return static_cast<uint32_t>(r) << 16 | static_cast<uint32_t>(g) << 8 | b; }
+
     struct HashFunction {
-      size_t operator()(const Color &aColor) const {
-        const size_t rHash = std::hash<int>()(aColor.r);
-        const size_t gHash = std::hash<int>()(aColor.g) << 1;
-        const size_t bHash = std::hash<int>()(aColor.b) << 2;
-        return rHash ^ gHash ^ bHash;
-      }
+      size_t operator()(const Color &aColor) const { return std::hash<uint32_t>()(aColor.packed()); }
     };
   };
   struct Vertex {
@@ -50,6 +57,23 @@ public:
 
     bool operator==(const Vertex& other) const { return x == other.x && y == other.y; }
   };
+  struct Run { // Horizontal run of pixels on the map, from start (inclusive) to end (exclusive)
+    int row, start, end;
+  };
+  struct Rect { // Rectangle of pixels on the map, ends are exclusive
+    int top, bottom, start, end;
+  };
+  struct Mesh {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+  };
+  struct Baked { // Everything a province gets out of the map, so it can be cached
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<Mesh> lods; // Level 1 onwards
+    vec2f center;
+    size_t area = 0;
+  };
 
   struct City { // City wrapper
     enum CityCategory {
@@ -135,44 +159,29 @@ public:
 
   City city; // The city inside this province
   Province(ErrorHandler* errorHandler,
-           const char* mapPath,
            Color color,
            std::string name,
            const City &city,
-           const std::unordered_set<Color, Color::HashFunction> &usedColors);
-  ~Province() noexcept {
-    // Clean up the mesh data
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-  }
-
-  Province(const Province& other) : city(other.city) {
-    name = other.name;
-
-    vertices = other.vertices;
-    indices = other.indices;
-    color = other.color;
-
-    center = other.center;
-    area = other.area;
-
-    adjacentColors = other.adjacentColors;
-
-    errorHandler = other.errorHandler;
+           const ProvinceMap &map,
+           size_t index);
+  Province(ErrorHandler* errorHandler,
+           Color color,
+           std::string name,
+           const City &city,
+           Baked baked);
+  ~Province() = default;
 
-    generateMeshData(); // Regenerate the mesh data, otherwise it won't render
-  }
+  // Provinces can hold quite a big mesh, so they only ever get moved around, never copied
+  Province(const Province&) = delete;
+  Province& operator=(const Province&) = delete;
+  Province(Province&&) noexcept = default;
+  Province& operator=(Province&&) noexcept = default;
 
   bool operator==(const Province &other) const {
     // In theory, this should be more than enough, and saves a lot of time
     return name == other.name && color == other.color;
   }
 
-  void render() const;
-
-  [[nodiscard]] bool clickedOn(float x, float y) const;
-
   [[nodiscard]] std::string getName() const { return name; }
   [[nodiscard]] Color getColor() const { return color; }
   [[nodiscard]] vec2f getCenter() const { return center; }
@@ -180,6 +189,17 @@ public:
   [[nodiscard]] float getCenterY() const { return center.y; }
 
   [[nodiscard]] size_t getArea() const { return area; }
+  // Of the mesh, in the same coordinates, covering every level of detail, since coarse ones stick out further
+  [[nodiscard]] const AABB& getBounds() const { return bounds; }
+
+  // The mesh only lives here on the CPU, the GPU copy is shared by every province (see ProvinceMesh)
+  // Level 0 is the full detail mesh, every level after that is built out of a map half as big as the last
+  [[nodiscard]] const std::vector<Vertex>& getVertices(const size_t level = 0) const {
+    return level == 0 ? vertices : lods[level - 1].vertices;
+  }
+  [[nodiscard]] const std::vector<unsigned int>& getIndices(const size_t level = 0) const {
+    return level == 0 ? indices : lods[level - 1].indices;
+  }
 
   [[nodiscard]] bool isAdjacent(const Color c) const { return adjacentColors.contains(c); }
   [[nodiscard]] bool isAdjacent(Province* p) const { return isAdjacent(p->getColor()); }
@@ -189,6 +209,10 @@ public:
   }
   [[nodiscard]] std::unordered_set<Color, Color::HashFunction> getAdjacentColorsSet() const { return adjacentColors; }
 
+  void setAdjacentColors(std::unordered_set<Color, Color::HashFunction> colors) { adjacentColors = std::move(colors); }
+
+  [[nodiscard]] Baked bake() const { return { vertices, indices, lods, center, area }; }
+
   void tick() {
     if (city.food < 0) {
       city.population -= city.population / 10; // If we have no food, we lose population
@@ -211,20 +235,28 @@ public:
   }
 
 private:
-  unsigned int VAO{}, VBO{}, EBO{};
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
+  std::vector<Mesh> lods; // Level 1 onwards
   Color color;
   std::string name;
   vec2f center;
   size_t area = 0; // The area of this province, in number of pixels
+  AABB bounds;
 
   std::unordered_set<Color, Color::HashFunction> adjacentColors;
 
   ErrorHandler* errorHandler;
 
-  void generateMesh(const char* mapPath, const std::unordered_set<Color, Color::HashFunction>& usedColors);
-  void generateMeshData();
+  void generateMesh(const ProvinceMap& map, size_t index);
+  void generateBounds() {
+    for (const auto& [x, y] : vertices) bounds.add(vec2f(x, y));
+    for (const auto& lod : lods) for (const auto& [x, y] : lod.vertices) bounds.add(vec2f(x, y));
+  }
+  bool generateContourMesh(const std::vector<Run>& runs, float x1, float y1);
+  static void addRects(const std::vector<Rect>& rects, int factor, vec2i dimensions, Mesh& mesh);
+  static std::vector<Rect> toRects(const std::vector<Run>& runs);
+  static std::vector<Rect> mergeRuns(const std::vector<Run>& runs); // Joins runs that line up vertically
 };
 
 #endif // PROVINCE_HPP
@@ -0,0 +1,46 @@
+#include "province_adjacency.hpp"
+
+ProvinceAdjacency::ProvinceAdjacency(const ProvinceRaster& raster, const WorkerPool& pool) {
+  const auto width = static_cast<size_t>(raster.getDimensions().x);
+  const auto height = static_cast<size_t>(raster.getDimensions().y);
+  const uint16_t* ids = raster.getIds().data();
+
+  // Every band counts the pixel edges in between different provinces, as packed pairs
+  // Borders tend to repeat the same pair many times in a row, so those get counted up on the spot
+  std::vector<std::vector<std::pair<uint32_t, uint32_t>>> bands(std::min(height, pool.size()));
+  pool.run(bands.size(), [&](const size_t b) {
+    auto& pairs = bands[b];
+    uint32_t last = UINT32_MAX, count = 0;
+    const auto add = [&](uint16_t p, uint16_t q) {
+      if (p == q || p == ProvinceRaster::NONE || q == ProvinceRaster::NONE) return;
+      if (p > q) std::swap(p, q);
+      if (const uint32_t k = key(p, q); k != last) {
+        if (count > 0) pairs.emplace_back(last, count);
+        last = k;
+        count = 0;
+      } count++;
+    };
+
+    // Adjacency is symmetric, so we only ever need to look right and down from each pixel
+    for (size_t row = b * height / bands.size(); row < (b + 1) * height / bands.size(); row++) {
+      const uint16_t* rowIds = ids + row * width;
+      for (size_t x = 0; x + 1 < width; x++) add(rowIds[x], rowIds[x + 1]);
+      if (row + 1 == height) continue;
+      const uint16_t* belowIds = rowIds + width;
+      for (size_t x = 0; x < width; x++) add(rowIds[x], belowIds[x]);
+    } if (count > 0) pairs.emplace_back(last, count);
+  });
+
+  // Sort all the pairs together, and add up the counts of the same ones
+  std::vector<std::pair<uint32_t, uint32_t>> pairs;
+  for (auto& band : bands) {
+    pairs.insert(pairs.end(), band.begin(), band.end());
+    band = {};
+  } std::ranges::sort(pairs, {}, &std::pair<uint32_t, uint32_t>::first);
+
+  for (const auto& [k, count] : pairs) {
+    const auto a = static_cast<uint16_t>(k >> 16), b = static_cast<uint16_t>(k & 0xFFFF);
+    if (!borders.empty() && borders.back().a == a && borders.back().b == b) borders.back().length += count;
+    else borders.push_back({ a, b, count });
+  }
+}
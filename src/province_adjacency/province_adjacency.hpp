@@ -0,0 +1,42 @@
+#ifndef PROVINCE_ADJACENCY_HPP
+#define PROVINCE_ADJACENCY_HPP
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+
+#include "../province_raster/province_raster.h"
+#include "../worker_pool/worker_pool.h"
+
+// Which provinces touch each other on the map, and how long the border in between them is
+class ProvinceAdjacency {
+public:
+  struct Border {
+    uint16_t a, b; // Province indices, with a < b
+    uint32_t length; // In pixel edges shared by both provinces
+  };
+
+  ProvinceAdjacency() = default;
+  // A single pass over the raster, split into bands of rows across the pool
+  ProvinceAdjacency(const ProvinceRaster& raster, const WorkerPool& pool);
+  ~ProvinceAdjacency() = default;
+
+  [[nodiscard]] const std::vector<Border>& getBorders() const { return borders; } // Sorted by a, and then by b
+
+  // 0 if they don't touch
+  [[nodiscard]] uint32_t getBorderLength(uint16_t a, uint16_t b) const {
+    if (a > b) std::swap(a, b);
+    const auto it = std::ranges::lower_bound(borders, key(a, b), {}, [](const Border& border) {
+      return key(border.a, border.b);
+    }); return it != borders.end() && it->a == a && it->b == b ? it->length : 0;
+  }
+
+private:
+  std::vector<Border> borders;
+
+  [[nodiscard]] static uint32_t key(const uint16_t a, const uint16_t b) {
+    return static_cast<uint32_t>(a) << 16 | b;
+  }
+};
+
+#endif // PROVINCE_ADJACENCY_HPP
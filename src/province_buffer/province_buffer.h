@@ -0,0 +1,77 @@
+#ifndef PROVINCE_BUFFER_H
+#define PROVINCE_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// One 32-bit value per province, kept on the GPU as a texture buffer, so shaders can look it up by province
+// Values only get uploaded where they changed, and only right before they're needed
+class ProvinceBuffer {
+public:
+  explicit ProvinceBuffer(const GLenum format) : format(format) {} // Any 32-bit texel format, like GL_RGBA8
+  ~ProvinceBuffer() noexcept {
+    glDeleteBuffers(1, &buffer);
+    glDeleteTextures(1, &texture);
+  }
+
+  ProvinceBuffer(const ProvinceBuffer&) = delete;
+  ProvinceBuffer& operator=(const ProvinceBuffer&) = delete;
+
+  // Only call this, and bind, from the thread that owns the GL context
+  void resize(const size_t count, const uint32_t value) {
+    if (buffer == 0) {
+      glGenBuffers(1, &buffer);
+      glGenTextures(1, &texture);
+    }
+
+    values.assign(count, value);
+    dirtyBegin = SIZE_MAX;
+    dirtyEnd = 0;
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    glBufferData(GL_TEXTURE_BUFFER,
+                 static_cast<GLsizeiptr>(values.size() * sizeof(uint32_t)),
+                 values.data(),
+                 GL_DYNAMIC_DRAW);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+  }
+
+  void set(const size_t province, const uint32_t value) {
+    if (values[province] == value) return;
+    values[province] = value;
+    dirtyBegin = std::min(dirtyBegin, province);
+    dirtyEnd = std::max(dirtyEnd, province + 1);
+  }
+  [[nodiscard]] uint32_t get(const size_t province) const { return values[province]; }
+  [[nodiscard]] size_t size() const { return values.size(); }
+
+  void bind(const unsigned int unit) {
+    if (dirtyBegin < dirtyEnd) {
+      glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+      glBufferSubData(GL_TEXTURE_BUFFER,
+                      static_cast<GLintptr>(dirtyBegin * sizeof(uint32_t)),
+                      static_cast<GLsizeiptr>((dirtyEnd - dirtyBegin) * sizeof(uint32_t)),
+                      values.data() + dirtyBegin);
+      glBindBuffer(GL_TEXTURE_BUFFER, 0);
+      dirtyBegin = SIZE_MAX;
+      dirtyEnd = 0;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_BUFFER, texture);
+    glActiveTexture(GL_TEXTURE0);
+  }
+
+private:
+  unsigned int buffer{}, texture{};
+  GLenum format;
+  std::vector<uint32_t> values; // CPU copy, so we know what changed
+  size_t dirtyBegin = SIZE_MAX, dirtyEnd = 0; // Range of values that still have to be uploaded
+};
+
+#endif // PROVINCE_BUFFER_H
@@ -4,20 +4,23 @@ ProvinceManager::ProvinceManager(ErrorHandler* errorHandler,
                                  const std::string& provShaderPath,
                                  const std::string& textShaderPath,
                                  const std::string& lineShaderPath,
+                                 const std::string& mapShaderPath,
                                  const std::string& mapPath,
-                                 const std::string& provPath) : provShader(errorHandler, provShaderPath),
+                                 const std::string& provPath,
+                                 const std::string& cachePath) : provShader(errorHandler, provShaderPath),
                                                                 textShader(errorHandler, textShaderPath),
                                                                 lineShader(errorHandler, lineShaderPath),
+                                                                mapShader(errorHandler, mapShaderPath),
+                                                                mapRenderer(errorHandler),
                                                                 text(errorHandler),
                                                                 errorHandler(errorHandler),
-                                                                line(errorHandler) {
+                                                                lines(errorHandler) {
   std::ifstream province_file(provPath);
   if (!province_file.is_open()) errorHandler->logFatal("Could not open file \"" + provPath + "\"",
     ErrorHandler::COULD_NOT_OPEN_FILE_ERROR);
 
   size_t i = 0; // Line number
   std::vector<QueuedProvince> queuedProvinces; // Read the provinces, queue them, and then generate them
-  std::unordered_set<Province::Color, Province::Color::HashFunction> usedColors; // For adjacency optimizations
   for (std::string fileLine; std::getline(province_file, fileLine); i++) {
     if (fileLine.empty()) continue;
     fileLine = fileLine.substr(fileLine.find_first_not_of(' '));
@@ -50,9 +53,13 @@ ProvinceManager::ProvinceManager(ErrorHandler* errorHandler,
       default: break;
     }
 
+    if (provinceLookup.contains(curProv[0])) {
+      errorHandler->logWarning("Province " + curProv[0] + " defined again at line " + std::to_string(i) +
+        ", skipping it", ErrorHandler::FORMAT_ERROR);
+      continue;
+    } provinceLookup.emplace(curProv[0], static_cast<ProvinceId>(queuedProvinces.size()));
+
     auto color = Province::Color(curProv[1]);
-    // Remember this color so we can check adjacency later, but only if it's not a wasteland
-    if (city.category != Province::City::WASTELAND) usedColors.emplace(color);
     queuedProvinces.push_back({ // Queue this province so we can render all of them at once
       curProv[0],
       color,
@@ -61,118 +68,221 @@ ProvinceManager::ProvinceManager(ErrorHandler* errorHandler,
     });
   } province_file.close();
 
-  // Generate queued provinces
-  for (const auto&[id, color, name, city] : queuedProvinces)
-    provinces.emplace(id, Province(errorHandler, mapPath.c_str(), color, name, city, usedColors));
-
-  // Generate adjacency map
-  for (const auto& [name, prov] : provinces) {
-    if (prov.city.category == Province::City::WASTELAND) continue; // Wastelands aren't connected to anything
-    std::unordered_set<std::string> adjProvs;
-    for (const auto& color : prov.getAdjacentColors()) {
-      for (const auto& [otherName, otherProv] : provinces) {
-        if (otherProv.getColor() != color) continue;
-        adjProvs.emplace(otherName);
-        break;
-      }
-    } adjacencyMap[name] = adjProvs;
+  const WorkerPool pool(PROVINCE_BUILD_THREADS);
+
+  // Everything we'd get out of the map might already be cached, in which case we don't even need to decode it
+  const MapCache cache(errorHandler, cachePath);
+  const uint64_t cacheKey = MapCache::key(mapPath, provPath);
+  provinces.reserve(queuedProvinces.size()); // Provinces never get copied around while we add them
+  if (auto cached = cache.load(cacheKey, queuedProvinces.size())) {
+    for (size_t j = 0; j < queuedProvinces.size(); j++) {
+      const auto&[id, color, name, city] = queuedProvinces[j];
+      provinces.emplace_back(errorHandler, color, name, city, std::move(cached->provinces[j]));
+    } raster = std::move(cached->raster);
+  } else {
+    // Decode the map only once, and share it with every province
+    std::vector<Province::Color> colors;
+    colors.reserve(queuedProvinces.size());
+    for (const auto& queuedProvince : queuedProvinces) colors.push_back(queuedProvince.color);
+    ProvinceMap map(errorHandler, mapPath, colors, pool);
+
+    // Generate queued provinces, building their meshes in parallel
+    std::vector<std::optional<Province>> built(queuedProvinces.size());
+    pool.run(queuedProvinces.size(), [&](const size_t j) {
+      const auto&[id, color, name, city] = queuedProvinces[j];
+      built[j].emplace(errorHandler, color, name, city, map, j);
+    });
+
+    MapCache::Contents toCache;
+    toCache.provinces.reserve(queuedProvinces.size());
+    for (size_t j = 0; j < queuedProvinces.size(); j++) {
+      toCache.provinces.push_back(built[j]->bake());
+      provinces.push_back(std::move(*built[j]));
+      built[j].reset();
+    }
+    toCache.raster = map.takeRaster();
+    cache.save(cacheKey, toCache);
+    raster = std::move(toCache.raster);
+  }
+
+  // Meshes get uploaded here, since this is the thread that owns the GL context
+  mesh.build(provinces);
+  errorHandler->logDebug("Province mesh: " + std::to_string(mesh.getVertexCount()) + " vertices, " +
+    std::to_string(mesh.getIndexCount()) + " indices, in a single buffer, over " +
+    std::to_string(PROVINCE_LOD_LEVELS) + " levels of detail");
+  if (!mapRenderer.build(raster, provinces.size())) rasterRender = false;
+  mapShader.use();
+  mapShader.setFloat("provinceBorderWidth", PROVINCE_BORDER_WIDTH);
+  mapShader.setVec4f("provinceBorderColor", PROVINCE_BORDER_COLOR);
+  mapShader.setFloat("stateBorderWidth", STATE_BORDER_WIDTH);
+  mapShader.setVec4f("stateBorderColor", STATE_BORDER_COLOR);
+
+  ramp.build(MAP_MODE_RAMP);
+  provMapMode = provShader.getUniform("mapMode");
+  mapMapMode = mapShader.getUniform("mapMode");
+
+  provinceIds.reserve(queuedProvinces.size());
+  for (const auto& queuedProvince : queuedProvinces) provinceIds.push_back(queuedProvince.id);
+  for (ProvinceId j = 0; j < provinces.size(); j++) { // Bigger provinces keep their names when they'd overlap
+    text.addLabel(provinceIds[j], PROVINCE_LABEL_SIZE, provinces[j].getCenter(),
+      static_cast<float>(provinces[j].getArea()));
+  }
+
+  // Adjacency comes straight out of the raster, in a single pass
+  adjacency = ProvinceAdjacency(raster, pool);
+  const auto connected = [&](const ProvinceId j) { // Wastelands aren't connected to anything
+    return provinces[j].city.category != Province::City::WASTELAND;
+  };
+  std::vector<std::unordered_set<Province::Color, Province::Color::HashFunction>> adjacentColors(provinces.size());
+  std::vector<std::vector<ProvinceId>> adjacent(provinces.size());
+  for (const auto& [a, b, length] : adjacency.getBorders()) {
+    if (connected(b)) adjacentColors[a].insert(provinces[b].getColor());
+    if (connected(a)) adjacentColors[b].insert(provinces[a].getColor());
+    if (!connected(a) || !connected(b)) continue;
+    adjacent[a].push_back(b);
+    adjacent[b].push_back(a);
+  }
+
+  // Flatten it all into a single array, with the smallest neighbours first, since that's what pathfinding wants
+  adjacencyOffsets.reserve(provinces.size() + 1);
+  adjacencyOffsets.push_back(0);
+  for (ProvinceId j = 0; j < provinces.size(); j++) {
+    provinces[j].setAdjacentColors(std::move(adjacentColors[j]));
+    std::ranges::stable_sort(adjacent[j], {}, [&](const ProvinceId k) { return provinces[k].getArea(); });
+    adjacencyTargets.insert(adjacencyTargets.end(), adjacent[j].begin(), adjacent[j].end());
+    adjacencyOffsets.push_back(static_cast<uint32_t>(adjacencyTargets.size()));
   }
 }
 
 void ProvinceManager::render(const Window& window,
                              const float scale,
                              const vec2f& offset,
-                             const std::unordered_map<std::string, Province::Color>& provColors) {
-  provShader.use();
-  for (auto &[id, province]: provinces) {
-    const auto color = provColors.at(id);
-    provShader.setVec3f("color",
-      static_cast<float>(color.r) / 255.0f,
-      static_cast<float>(color.g) / 255.0f,
-      static_cast<float>(color.b) / 255.0f);
-    provShader.setVec2f("center", province.getCenter());
-    province.render();
+                             const Text* labelsAbove) {
+  const AABB view = getView(scale, offset);
+  ramp.bind(MAP_MODE_RAMP_UNIT);
+  if (rasterRender) {
+    mapShader.use();
+    mesh.bindColors();
+    mapRenderer.render(); // The whole map in a single quad
+  } else {
+    provShader.use();
+    mesh.render(view, getLevel(window, scale)); // Every visible province in a single draw call
   }
 
   lineShader.use();
-  line.render();
+  lines.render(scale); // Every path in a single draw call
 
   // Don't render text if zoomed out too far or offscreen
   if (scale > 0.5f || offset > vec2f(1.0f) || offset < vec2f(-1.0f)) return;
 
-  // TODO(Dory): Find a better way to do province name text
   textShader.use();
-  for (auto &[name, province] : provinces) {
-    text.setText(name, 5.0f, province.getCenter(), static_cast<vec2f>(window.getDimensions()), offset);
-    textShader.setVec2f("center", province.getCenter());
-    text.render();
+  // Every visible name in a single draw call
+  text.render(static_cast<vec2f>(window.getDimensions()), view, labelsAbove);
+}
+
+void ProvinceManager::setMapMode(const MapMode mode) {
+  mapMode = mode;
+  provShader.use();
+  provShader.setBool(provMapMode, mode != POLITICAL_MODE);
+  mapShader.use();
+  mapShader.setBool(mapMapMode, mode != POLITICAL_MODE);
+  refreshMapMode();
+}
+
+std::string ProvinceManager::getMapModeName(const MapMode mode) {
+  switch (mode) {
+    case POLITICAL_MODE: return "political";
+    case POPULATION_MODE: return "population";
+    case WEALTH_MODE: return "wealth";
+    case FOOD_MODE: return "food";
+    case PRODUCTION_MODE: return "production";
+    case STRENGTH_MODE: return "strength";
+    default: return "unknown";
   }
 }
 
-std::string ProvinceManager::clickedOnProvince(const float x, const float y) {
-  for (auto &[name, province] : provinces) if (province.clickedOn(x, y)) return name;
-  return "";
+void ProvinceManager::refreshMapMode() {
+  int Province::City::* field;
+  switch (mapMode) {
+    case POPULATION_MODE: field = &Province::City::population; break;
+    case WEALTH_MODE: field = &Province::City::wealth; break;
+    case FOOD_MODE: field = &Province::City::food; break;
+    case PRODUCTION_MODE: field = &Province::City::production; break;
+    case STRENGTH_MODE: field = &Province::City::strength; break;
+    default: return; // Political colors are always up to date
+  }
+
+  // Normalized against the highest value, wastelands keep their own color since they never have any
+  const auto shown = [](const Province& province) { return province.city.category != Province::City::WASTELAND; };
+  int highest = 0;
+  for (const auto& province : provinces) if (shown(province)) highest = std::max(highest, province.city.*field);
+  const float inverse = highest > 0 ? 1.0f / static_cast<float>(highest) : 0.0f;
+  for (ProvinceId i = 0; i < provinces.size(); i++)
+    mesh.setValue(i, shown(provinces[i]) ? static_cast<float>(provinces[i].city.*field) * inverse : -1.0f);
+}
+
+size_t ProvinceManager::getLevel(const Window& window, const float scale) const {
+  // The view is 2 * scale wide, and the whole map is 2 wide, so this is how many map pixels every screen pixel covers
+  const vec2f dimensions = static_cast<vec2f>(raster.getDimensions());
+  const vec2f windowDimensions = static_cast<vec2f>(window.getDimensions());
+  if (windowDimensions.x <= 0.0f || windowDimensions.y <= 0.0f) return 0; // Minimized
+  const float pixels = scale * std::max(dimensions.x / windowDimensions.x, dimensions.y / windowDimensions.y);
+  if (pixels < 2.0f) return 0;
+  return std::min(static_cast<size_t>(std::log2(pixels)), static_cast<size_t>(PROVINCE_LOD_LEVELS - 1));
 }
 
-ProvinceManager::Connection ProvinceManager::findPath(const std::string& provinceA, const std::string& provinceB) {
+std::map<std::string, std::unordered_set<std::string>> ProvinceManager::getAdjacencyMap() const {
+  std::map<std::string, std::unordered_set<std::string>> adjacencyMap;
+  for (ProvinceId i = 0; i < provinces.size(); i++) {
+    if (provinces[i].city.category == Province::City::WASTELAND) continue;
+    auto& adjProvs = adjacencyMap[provinceIds[i]];
+    for (const ProvinceId adj : getAdjacent(i)) adjProvs.emplace(provinceIds[adj]);
+  } return adjacencyMap;
+}
+
+ProvinceManager::Connection ProvinceManager::findPath(const ProvinceId provinceA, const ProvinceId provinceB) {
   Connection connection;
-  if (!provinces.contains(provinceA) || !provinces.contains(provinceB) ||
-      provinces.at(provinceA).city.category == Province::City::WASTELAND ||
-      provinces.at(provinceB).city.category == Province::City::WASTELAND) return connection;
+  if (provinceA >= provinces.size() || provinceB >= provinces.size() ||
+      provinces[provinceA].city.category == Province::City::WASTELAND ||
+      provinces[provinceB].city.category == Province::City::WASTELAND) return connection;
   if (provinceA == provinceB) {
     connection.steps = 0;
     return connection;
   }
 
-  // BFS to find the shortest path
-  std::list<std::pair<std::string, std::string>> parent;
-  std::queue<std::string> toVisit;
-  std::unordered_set<std::string> visited;
-
+  // BFS to find the shortest path, neighbours come smallest first
+  std::vector parent(provinces.size(), NO_PROVINCE);
+  std::queue<ProvinceId> toVisit;
+  parent[provinceA] = provinceA;
   toVisit.push(provinceA); // Start from province A
 
-  bool found = false;
-  while (!toVisit.empty()) {
-    // Get first element
-    std::string cur = toVisit.front();
+  while (!toVisit.empty() && parent[provinceB] == NO_PROVINCE) {
+    const ProvinceId cur = toVisit.front();
     toVisit.pop();
-
-    // Sort for optimization
-    std::vector adjProvs(adjacencyMap.at(cur).begin(), adjacencyMap.at(cur).end());
-    std::ranges::sort(adjProvs, [&provinces = this->provinces](const std::string& a, const std::string& b) {
-      return provinces.at(a).getArea() < provinces.at(b).getArea();
-    });
-
-    for (const std::string& adj : adjProvs) {
-      if (visited.contains(adj)) continue;
-      parent.emplace_back(adj, cur);
+    for (const ProvinceId adj : getAdjacent(cur)) {
+      if (parent[adj] != NO_PROVINCE) continue;
+      parent[adj] = cur;
       toVisit.push(adj);
-      if (adj != provinceB) continue;
-      found = true;
-      break;
-    } visited.emplace(cur);
-    if (found) break;
-  } if (!found) return connection; // Not connected
+      if (adj == provinceB) break;
+    }
+  } if (parent[provinceB] == NO_PROVINCE) return connection; // Not connected
 
   // Reconstruct path
-  std::list<std::pair<std::string, Province>> path;
-  for (std::string cur = provinceB; cur != provinceA;) {
-    path.emplace_front(cur, provinces.at(cur));
-    auto it = std::ranges::find_if(parent,
-      [&cur](const std::pair<std::string, std::string> &p) { return p.first == cur; });
-    if (it == parent.end()) break; // Shouldn't happen
-    cur = it->second;
-  } path.emplace_front(provinceA, provinces.at(provinceA));
+  auto& path = connection.provinces;
+  for (ProvinceId cur = provinceB; cur != provinceA; cur = parent[cur]) path.emplace_back(provinceIds[cur], cur);
+  path.emplace_back(provinceIds[provinceA], provinceA);
+  std::ranges::reverse(path);
 
   // Generate connection
   connection.steps = static_cast<int>(path.size()) - 1;
-  connection.provinces = path;
 
   std::vector<vec2f> linePoints;
-  for (const auto &prov: path | std::views::values) linePoints.push_back(prov.getCenter());
-  line.setPoints(linePoints);
+  linePoints.reserve(path.size());
+  for (const ProvinceId prov: path | std::views::values) linePoints.push_back(provinces[prov].getCenter());
+  if (lastPath == LineBatch::NO_PATH) lastPath = lines.add(std::move(linePoints));
+  else lines.set(lastPath, std::move(linePoints));
 
-  connection.length = line.length;
+  connection.length = lines.getLength(lastPath);
 
   return connection;
-}
\ No newline at end of file
+}
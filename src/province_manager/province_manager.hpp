@@ -6,17 +6,34 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <ranges>
-#include <list>
 #include <vector>
 #include <queue>
+#include <optional>
+#include <span>
 
 #include "../utils.hpp"
 #include "../window/window.hpp"
 #include "../shader/shader.hpp"
 #include "../province/province.hpp"
+#include "../province_mesh/province_mesh.hpp"
+#include "../map_renderer/map_renderer.hpp"
+#include "../province_map/province_map.hpp"
+#include "../map_cache/map_cache.hpp"
+#include "../color_ramp/color_ramp.h"
+#include "../province_raster/province_raster.h"
+#include "../province_adjacency/province_adjacency.hpp"
 #include "../text/text.hpp"
 #include "../error_handler/error_handler.h"
 #include "../line/line.h"
+#include "../line_batch/line_batch.hpp"
+#include "../worker_pool/worker_pool.h"
+
+#define PROVINCE_BUILD_THREADS 0 // Threads used to build the provinces (0 = one per core, 1 = serial)
+#define PROVINCE_RASTER_RENDER false // Draw the map out of the province ID texture (false = province meshes)
+#define PROVINCE_LABEL_SIZE 5.0f // Font size of the province names, in pixels when fully zoomed out
+#define MAP_MODE_RAMP_UNIT 4 // Texture unit of the map mode color ramp, has to match the province shaders
+// Colors map modes go through, from the lowest value to the highest, evenly spaced
+#define MAP_MODE_RAMP { { 68, 1, 84 }, { 59, 82, 139 }, { 33, 145, 140 }, { 94, 201, 98 }, { 253, 231, 37 } }
 
 class ProvinceManager {
 public:
@@ -32,53 +49,139 @@ public:
     float length = 0.0f; // Total length of the path
 
     // What provinces to traverse
-    std::list<std::pair<std::string, Province>> provinces; // Should be ordered for consistency
+    std::vector<std::pair<std::string, ProvinceId>> provinces; // Should be ordered for consistency
 
     bool operator==(const Connection& other) const { return steps == other.steps && provinces == other.provinces; }
   };
 
-  Shader provShader, textShader, lineShader;
+  Shader provShader, textShader, lineShader, mapShader;
 
   explicit ProvinceManager(ErrorHandler* errorHandler,
                            const std::string& provShaderPath = "res/shaders/default",
                            const std::string& textShaderPath = "res/shaders/text",
                            const std::string& lineShaderPath = "res/shaders/line",
+                           const std::string& mapShaderPath = "res/shaders/map",
                            const std::string& mapPath = "res/test.png",
-                           const std::string& provPath = "res/provinces.txt");
+                           const std::string& provPath = "res/provinces.txt",
+                           const std::string& cachePath = "cache/map.cache"); // Empty to disable the cache
   ~ProvinceManager() = default;
 
   ProvinceManager(const ProvinceManager&) = delete;
   ProvinceManager& operator=(const ProvinceManager&) = delete;
 
-  void render(const Window& window,
-              float scale,
-              const vec2f& offset,
-              const std::unordered_map<std::string, Province::Color>& provColors);
-  [[nodiscard]] std::string clickedOnProvince(float x, float y);
-  [[nodiscard]] std::string clickedOnProvince(const vec2f& pos) { return clickedOnProvince(pos.x, pos.y); }
+  // Province names overlapping any placed label of labelsAbove are left out, it has to be updated before this
+  void render(const Window& window, float scale, const vec2f& offset, const Text* labelsAbove = nullptr);
+  // Level of detail of the province meshes, so that no cell of it is smaller than a screen pixel
+  [[nodiscard]] size_t getLevel(const Window& window, float scale) const;
+  // What part of the map the camera can see, in the same coordinates as the province meshes
+  [[nodiscard]] static AABB getView(const float scale, const vec2f& offset) {
+    return { offset - scale, offset + scale };
+  }
+  // Switches in between drawing the map from the province ID texture, and from the province meshes
+  void toggleRenderer() { rasterRender = !rasterRender && mapRenderer.isBuilt(); }
+  [[nodiscard]] bool isRasterRender() const { return rasterRender; }
+
+  enum MapMode { // What provinces get colored by
+    POLITICAL_MODE, // Their own color, or their state's
+    POPULATION_MODE,
+    WEALTH_MODE,
+    FOOD_MODE,
+    PRODUCTION_MODE,
+    STRENGTH_MODE,
+    MAP_MODE_COUNT
+  };
+  // Only one value per province gets uploaded, and only where it changed, the shader does the rest through the ramp
+  void setMapMode(MapMode mode);
+  [[nodiscard]] MapMode getMapMode() const { return mapMode; }
+  [[nodiscard]] static std::string getMapModeName(MapMode mode);
+  void refreshMapMode(); // Call whenever the values the current map mode shows change, ticking already does
+
+  // Colors live on the GPU, so this only uploads what actually changed, on the next render
+  void setProvinceColor(const ProvinceId province, const Province::Color color) { mesh.setColor(province, color); }
+  void setProvinceOwner(const ProvinceId province, const uint32_t owner) { mapRenderer.setOwner(province, owner); }
+
+  // Provinces are referred to by dense handles, in the same order as the province file
+  // The string ids from the file are only kept around for the functions that take or give them
+  [[nodiscard]] size_t getProvinceCount() const { return provinces.size(); }
+  [[nodiscard]] ProvinceId getProvinceId(const std::string& id) const {
+    const auto it = provinceLookup.find(id);
+    return it == provinceLookup.end() ? NO_PROVINCE : it->second;
+  }
+  [[nodiscard]] const std::string& getProvinceIdString(const ProvinceId province) const {
+    return provinceIds[province];
+  }
+
+  [[nodiscard]] ProvinceId clickedOnProvinceId(const float x, const float y) const {
+    const uint16_t index = raster.atNDC(x, y);
+    return index == ProvinceRaster::NONE ? NO_PROVINCE : index;
+  }
+  [[nodiscard]] std::string clickedOnProvince(const float x, const float y) const {
+    const ProvinceId province = clickedOnProvinceId(x, y);
+    return province == NO_PROVINCE ? "" : provinceIds[province];
+  }
+  [[nodiscard]] std::string clickedOnProvince(const vec2f& pos) const { return clickedOnProvince(pos.x, pos.y); }
+
+  [[nodiscard]] Province& getProvince(const ProvinceId province) { return provinces[province]; }
+  [[nodiscard]] const Province& getProvince(const ProvinceId province) const { return provinces[province]; }
+  [[nodiscard]] Province& getProvince(const std::string& id) { return provinces[provinceLookup.at(id)]; }
+  [[nodiscard]] const ProvinceRaster& getRaster() const { return raster; }
+
+  [[nodiscard]] const std::vector<Province>& getAllProvinces() const { return provinces; } // Indexed by ProvinceId
+  [[nodiscard]] std::map<std::string, const Province*> getAllProvincesMap() const {
+    std::map<std::string, const Province*> provinceMap;
+    for (ProvinceId i = 0; i < provinces.size(); i++) provinceMap.emplace(provinceIds[i], &provinces[i]);
+    return provinceMap;
+  }
+
+  // Provinces you can walk to from the given one, smallest first, so wastelands never have any
+  [[nodiscard]] std::span<const ProvinceId> getAdjacent(const ProvinceId province) const {
+    return { adjacencyTargets.data() + adjacencyOffsets[province],
+             adjacencyTargets.data() + adjacencyOffsets[province + 1] };
+  }
+  [[nodiscard]] std::map<std::string, std::unordered_set<std::string>> getAdjacencyMap() const;
+  [[nodiscard]] const ProvinceAdjacency& getAdjacency() const { return adjacency; }
 
-  [[nodiscard]] Province& getProvince(const std::string& name) { return provinces.at(name); }
+  // How many pixel edges two provinces share, 0 if they don't touch, or if either of them doesn't exist
+  [[nodiscard]] uint32_t getBorderLength(const ProvinceId provinceA, const ProvinceId provinceB) const {
+    if (provinceA >= provinces.size() || provinceB >= provinces.size()) return 0;
+    return adjacency.getBorderLength(static_cast<uint16_t>(provinceA), static_cast<uint16_t>(provinceB));
+  }
+  [[nodiscard]] uint32_t getBorderLength(const std::string& provinceA, const std::string& provinceB) const {
+    return getBorderLength(getProvinceId(provinceA), getProvinceId(provinceB));
+  }
 
-  [[nodiscard]] std::vector<Province> getAllProvinces() const {
-    std::vector<Province> provinceList;
-    provinceList.reserve(provinces.size());
-    for (const auto &province: provinces | std::views::values) provinceList.push_back(province);
-    return provinceList;
+  [[nodiscard]] Connection findPath(ProvinceId provinceA, ProvinceId provinceB);
+  [[nodiscard]] Connection findPath(const std::string& provinceA, const std::string& provinceB) {
+    return findPath(getProvinceId(provinceA), getProvinceId(provinceB));
   }
-  [[nodiscard]] std::map<std::string, Province> getAllProvincesMap() const { return provinces; }
-  [[nodiscard]] std::map<std::string, std::unordered_set<std::string>> getAdjacencyMap() const { return adjacencyMap; }
 
-  [[nodiscard]] Connection findPath(const std::string& provinceA, const std::string& provinceB);
+  // Add any routes to show on the map in here, they're kept on the GPU until they get removed
+  [[nodiscard]] LineBatch& getLines() { return lines; }
 
-  void tick() { for (auto& province : provinces | std::views::values) province.tick(); }
+  void tick() {
+    for (auto& province : provinces) province.tick();
+    refreshMapMode();
+  }
 
 private:
-  std::map<std::string, Province> provinces;
-  Text text;
+  std::vector<Province> provinces; // Indexed by ProvinceId
+  ProvinceMesh mesh; // GPU side of every province mesh
+  MapRenderer mapRenderer; // Or the whole map at once, out of the raster
+  bool rasterRender = PROVINCE_RASTER_RENDER;
+  ColorRamp ramp; // For the map modes
+  MapMode mapMode = POLITICAL_MODE;
+  Shader::Uniform provMapMode, mapMapMode; // Whether there's a map mode, in both province shaders
+  std::vector<std::string> provinceIds; // The other way around
+  std::unordered_map<std::string, ProvinceId> provinceLookup;
+  ProvinceRaster raster; // Province of every pixel of the map
+  Text text; // Every province name, labels have the same handles as the provinces
   ErrorHandler* errorHandler;
-  Line line; // For debugging paths
+  LineBatch lines; // Every path on the map, all drawn at once
+  LineBatch::Path lastPath = LineBatch::NO_PATH; // Of the last findPath, for debugging
 
-  std::map<std::string, std::unordered_set<std::string>> adjacencyMap;
+  ProvinceAdjacency adjacency;
+  std::vector<uint32_t> adjacencyOffsets; // Where the neighbours of every province start in adjacencyTargets
+  std::vector<ProvinceId> adjacencyTargets;
 };
 
 #endif // PROVINCE_MANAGER_HPP
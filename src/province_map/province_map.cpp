@@ -0,0 +1,127 @@
+#include "province_map.hpp"
+
+ProvinceMap::ProvinceMap(ErrorHandler* errorHandler,
+                         const std::string& mapPath,
+                         const std::vector<Province::Color>& colors,
+                         const WorkerPool& pool) :
+errorHandler(errorHandler) {
+  // If we don't do this, we'll get vertically flipped provinces
+  stbi_set_flip_vertically_on_load(false);
+
+  int n;
+  unsigned char* data = stbi_load(mapPath.c_str(), &dimensions.x, &dimensions.y, &n, 0);
+  if (!data) errorHandler->logFatal("Failed to load map texture",
+    ErrorHandler::FILE_NOT_SUCCESSFULLY_READ_ERROR);
+  if (n < 3) {
+    stbi_image_free(data);
+    errorHandler->logFatal("Map texture must have at least 3 color channels", ErrorHandler::FORMAT_ERROR);
+  }
+
+  const auto width = static_cast<size_t>(dimensions.x);
+  const auto height = static_cast<size_t>(dimensions.y);
+  const auto channels = static_cast<size_t>(n);
+  const size_t stride = width * channels;
+
+  if (colors.size() > ProvinceRaster::MAX_PROVINCES) {
+    stbi_image_free(data);
+    errorHandler->logFatal("Too many provinces, at most " + std::to_string(ProvinceRaster::MAX_PROVINCES) +
+      " are supported", ErrorHandler::FORMAT_ERROR);
+  }
+
+  std::vector<uint32_t> packedColors;
+  packedColors.reserve(colors.size());
+  for (const auto& color : colors) packedColors.push_back(color.packed());
+  const ColorIndex colorIndex(packedColors);
+  if (colorIndex.getDuplicates() > 0)
+    errorHandler->logWarning("More than one province uses the same color, only the first one will get any pixels",
+      ErrorHandler::FORMAT_ERROR);
+  shapes.resize(colors.size());
+  std::vector<uint16_t> ids(width * height, ProvinceRaster::NONE);
+
+  // Every band of rows is scanned on its own, and then merged in order, so the result
+  // is exactly the same no matter how many bands we use
+  std::vector<std::vector<std::pair<size_t, Province::Run>>> bands(std::min(height, pool.size())); // Index and run
+
+  const PixelScan scan(channels);
+  const auto scanStart = std::chrono::steady_clock::now();
+
+  pool.run(bands.size(), [&](const size_t b) {
+    auto& bandRuns = bands[b];
+
+    // Runs next to each other mostly come from the same few provinces, so remember the last one we looked up
+    uint32_t lastColor = ColorIndex::NONE, lastIndex = ColorIndex::NONE;
+    const auto find = [&](const Province::Color c) {
+      if (const uint32_t packed = c.packed(); packed != lastColor) {
+        lastColor = packed;
+        lastIndex = colorIndex.find(packed);
+      } return lastIndex;
+    };
+
+    for (size_t row = b * height / bands.size(); row < (b + 1) * height / bands.size(); row++) {
+      const unsigned char* rowData = data + row * stride;
+      for (size_t start = 0; start < width;) {
+        const unsigned char* pixel = rowData + start * channels;
+        const uint32_t index = find(Province::Color(pixel[0], pixel[1], pixel[2]));
+        const size_t end = scan.mismatch(rowData, start + 1, width, pixel);
+
+        if (index != ColorIndex::NONE) {
+          bandRuns.emplace_back(index, Province::Run{
+            static_cast<int>(row), static_cast<int>(start), static_cast<int>(end)
+          });
+          // Every band only ever writes its own rows
+          std::fill(ids.data() + row * width + start, ids.data() + row * width + end, static_cast<uint16_t>(index));
+        }
+        start = end;
+      }
+    }
+  }); stbi_image_free(data);
+  raster = ProvinceRaster(dimensions, std::move(ids));
+  const auto scanTime = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - scanStart);
+
+  // Merge the bands, in order
+  for (auto& bandRuns : bands) {
+    for (const auto& [index, run] : bandRuns) shapes[index].runs.push_back(run);
+    bandRuns = {};
+  }
+
+  // Every level of detail samples the middle pixel of every cell, so provinces keep tiling with each other
+  // Levels don't share anything, so each one can go on its own thread
+  for (auto& shape : shapes) shape.lodRuns.resize(PROVINCE_LOD_LEVELS - 1);
+  pool.run(PROVINCE_LOD_LEVELS - 1, [&](const size_t l) {
+    const size_t factor = size_t(2) << l;
+    const size_t cellsX = (width + factor - 1) / factor, cellsY = (height + factor - 1) / factor;
+    for (size_t cy = 0; cy < cellsY; cy++) {
+      const uint16_t* rowIds = raster.getIds().data() + std::min(cy * factor + factor / 2, height - 1) * width;
+      const auto cell = [&](const size_t cx) { return rowIds[std::min(cx * factor + factor / 2, width - 1)]; };
+      for (size_t start = 0; start < cellsX;) {
+        const uint16_t id = cell(start);
+        size_t end = start + 1;
+        while (end < cellsX && cell(end) == id) end++;
+        if (id != ProvinceRaster::NONE) shapes[id].lodRuns[l].push_back({
+          static_cast<int>(cy), static_cast<int>(start), static_cast<int>(end)
+        });
+        start = end;
+      }
+    }
+  });
+
+  const float x1 = 2.0f / static_cast<float>(dimensions.x);
+  const float y1 = -2.0f / static_cast<float>(dimensions.y);
+  pool.run(shapes.size(), [&](const size_t i) {
+    auto& [runs, lodRuns, area, center] = shapes[i];
+    if (runs.empty()) return;
+    for (const auto& [row, start, end] : runs) {
+      area += static_cast<size_t>(end - start);
+
+      const float p = static_cast<float>(start) * x1 - 1.0f;
+      const float p0 = static_cast<float>(end) * x1 - 1.0f;
+      const float q = static_cast<float>(row) * y1 + 1.0f;
+      center += vec2f(p + p0, q + q + y1);
+    } center /= static_cast<float>(4 * runs.size()); // Same as averaging every vertex of every quad
+  });
+
+  errorHandler->logDebug("Loaded map \"" + mapPath + "\" (" + std::to_string(dimensions.x) + "x" +
+    std::to_string(dimensions.y) + ") for " + std::to_string(colors.size()) + " provinces, using " +
+    std::to_string(bands.size()) + " bands, scanned in " + std::to_string(scanTime.count()) + "ms with the " +
+    scan.getKernelName() + " kernel");
+}
@@ -0,0 +1,50 @@
+#ifndef PROVINCE_MAP_HPP
+#define PROVINCE_MAP_HPP
+
+#include <string>
+#include <chrono>
+#include <vector>
+
+#include "../utils.hpp"
+#include "../province/province.hpp" // Include for stb_image
+#include "../error_handler/error_handler.h"
+#include "../worker_pool/worker_pool.h"
+#include "../color_index/color_index.h"
+#include "../pixel_scan/pixel_scan.hpp"
+#include "../province_raster/province_raster.h"
+
+// Decodes the province map once, and buckets every pixel of it into its province in a single scan
+class ProvinceMap {
+public:
+  struct Shape { // Everything a province needs to know about itself from the map
+    std::vector<Province::Run> runs; // Horizontal runs of pixels, in scan order
+    std::vector<std::vector<Province::Run>> lodRuns; // Same, but in cells of 2^level pixels, from level 1 onwards
+    size_t area = 0; // In number of pixels
+    vec2f center;
+  };
+
+  // Shapes are indexed in the same order as the given colors
+  // The scan is split into bands of rows across the pool, with the same result as a serial scan
+  ProvinceMap(ErrorHandler* errorHandler,
+              const std::string& mapPath,
+              const std::vector<Province::Color>& colors,
+              const WorkerPool& pool);
+  ~ProvinceMap() = default;
+
+  ProvinceMap(const ProvinceMap&) = delete;
+  ProvinceMap& operator=(const ProvinceMap&) = delete;
+
+  [[nodiscard]] vec2i getDimensions() const { return dimensions; }
+  [[nodiscard]] const Shape& getShape(const size_t index) const { return shapes[index]; }
+  [[nodiscard]] const ProvinceRaster& getRaster() const { return raster; }
+  [[nodiscard]] ProvinceRaster takeRaster() { return std::move(raster); } // Leaves this map without one
+
+private:
+  vec2i dimensions;
+  std::vector<Shape> shapes;
+  ProvinceRaster raster;
+
+  ErrorHandler* errorHandler;
+};
+
+#endif // PROVINCE_MAP_HPP
@@ -0,0 +1,136 @@
+#include "province_mesh.hpp"
+
+ProvinceMesh::~ProvinceMesh() noexcept {
+  // Clean up the mesh data
+  glDeleteVertexArrays(1, &VAO);
+  glDeleteBuffers(1, &VBO);
+  glDeleteBuffers(1, &EBO);
+  glDeleteBuffers(1, &commandBuffer);
+  glDeleteBuffers(1, &centerBuffer);
+}
+
+void ProvinceMesh::build(const std::vector<Province>& provinces) {
+  // Indices stay relative to their own province, baseVertex takes care of the rest
+  // baseInstance is the province itself, so draws can be culled without losing track of what they are
+  // Every level of detail goes in the same buffers, one after the other
+  bounds.clear();
+  bounds.reserve(provinces.size());
+  std::vector<vec2f> centers;
+  centers.reserve(provinces.size());
+  for (const auto& province : provinces) {
+    bounds.push_back(province.getBounds());
+    centers.push_back(province.getCenter());
+  }
+
+  vertexCount = indexCount = 0;
+  for (size_t level = 0; level < PROVINCE_LOD_LEVELS; level++) {
+    for (const auto& province : provinces) {
+      vertexCount += province.getVertices(level).size();
+      indexCount += province.getIndices(level).size();
+    }
+  }
+
+  std::vector<Province::Vertex> vertices;
+  std::vector<unsigned int> indices;
+  vertices.reserve(vertexCount);
+  indices.reserve(indexCount);
+  for (size_t level = 0; level < PROVINCE_LOD_LEVELS; level++) {
+    auto& levelCommands = commands[level];
+    levelCommands.clear();
+    levelCommands.reserve(provinces.size());
+    for (size_t i = 0; i < provinces.size(); i++) {
+      const auto& provinceVertices = provinces[i].getVertices(level);
+      const auto& provinceIndices = provinces[i].getIndices(level);
+      levelCommands.push_back({
+        static_cast<GLuint>(provinceIndices.size()),
+        1,
+        static_cast<GLuint>(indices.size()),
+        static_cast<GLint>(vertices.size()),
+        static_cast<GLuint>(i)
+      });
+      vertices.insert(vertices.end(), provinceVertices.begin(), provinceVertices.end());
+      indices.insert(indices.end(), provinceIndices.begin(), provinceIndices.end());
+    }
+  }
+
+  if (VAO == 0) {
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &centerBuffer);
+  }
+
+  // Bind VAO
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glBufferData(GL_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(vertices.size() * sizeof(Province::Vertex)),
+               vertices.data(),
+               GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(indices.size() * sizeof(unsigned int)),
+               indices.data(),
+               GL_STATIC_DRAW);
+
+  glVertexAttribPointer(0,
+                        2,
+                        GL_FLOAT,
+                        GL_FALSE,
+                        sizeof(Province::Vertex),
+                        nullptr);
+  glEnableVertexAttribArray(0);
+
+  glBindVertexArray(0);
+
+  // Filled in with whatever's visible on the next render
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               static_cast<GLsizeiptr>(provinces.size() * sizeof(DrawCommand)),
+               nullptr,
+               GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, centerBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               static_cast<GLsizeiptr>(centers.size() * sizeof(vec2f)),
+               centers.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+  colors.resize(provinces.size(), pack(Province::Color())); // Black until someone gives them a color
+  values.resize(provinces.size(), std::bit_cast<uint32_t>(-1.0f)); // No map mode yet
+
+  lastView = AABB(); // Empty, so the first render always culls
+  drawCount = 0;
+}
+
+void ProvinceMesh::render(const AABB& view, size_t level) {
+  level = std::min(level, static_cast<size_t>(PROVINCE_LOD_LEVELS - 1));
+  if (view != lastView || level != lastLevel) { // The camera moved, so redo the culling
+    visibleCommands.clear();
+    for (size_t i = 0; i < commands[level].size(); i++)
+      if (commands[level][i].count > 0 && bounds[i].intersects(view)) visibleCommands.push_back(commands[level][i]);
+    lastView = view;
+    lastLevel = level;
+    drawCount = static_cast<GLsizei>(visibleCommands.size());
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER,
+                    0,
+                    static_cast<GLsizeiptr>(visibleCommands.size() * sizeof(DrawCommand)),
+                    visibleCommands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+
+  if (drawCount == 0) return;
+  bindColors();
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, PROVINCE_CENTER_BINDING, centerBuffer);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, drawCount, 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+}
@@ -0,0 +1,71 @@
+#ifndef PROVINCE_MESH_HPP
+#define PROVINCE_MESH_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <cstdint>
+#include <bit>
+
+#include "../province/province.hpp"
+#include "../province_buffer/province_buffer.h"
+
+#define PROVINCE_CENTER_BINDING 0 // SSBO binding of the province centers, has to match the province shader
+#define PROVINCE_COLOR_UNIT 0 // Texture unit of the per-province colors, has to match the province shader
+#define PROVINCE_VALUE_UNIT 3 // Texture unit of the per-province map mode values, has to match the province shader
+
+// Every province mesh packed into a single vertex and index buffer, drawn with one indirect call
+// Only provinces in view get a draw, and the shader finds out which province it's drawing through gl_BaseInstance
+class ProvinceMesh {
+public:
+  ProvinceMesh() = default;
+  ~ProvinceMesh() noexcept;
+
+  ProvinceMesh(const ProvinceMesh&) = delete;
+  ProvinceMesh& operator=(const ProvinceMesh&) = delete;
+
+  // Only call this, and render, from the thread that owns the GL context
+  void build(const std::vector<Province>& provinces);
+  // Provinces completely outside of the view don't get drawn at all
+  // Levels go from 0 (full detail) to PROVINCE_LOD_LEVELS - 1, see Province::getVertices
+  void render(const AABB& view, size_t level);
+  // Uploads whatever colors and values changed, and binds them for any shader that needs them
+  void bindColors() {
+    colors.bind(PROVINCE_COLOR_UNIT);
+    values.bind(PROVINCE_VALUE_UNIT);
+  }
+
+  // Colors stay on the GPU, and only the ones that changed get uploaded on the next render
+  void setColor(const size_t province, const Province::Color color) { colors.set(province, pack(color)); }
+  // Same for the values map modes color provinces by, from 0 to 1, or negative to keep the province's own color
+  void setValue(const size_t province, const float value) { values.set(province, std::bit_cast<uint32_t>(value)); }
+
+  [[nodiscard]] size_t getVertexCount() const { return vertexCount; } // Of every level
+  [[nodiscard]] size_t getIndexCount() const { return indexCount; }
+  [[nodiscard]] size_t getVisibleCount() const { return static_cast<size_t>(drawCount); }
+
+private:
+  struct DrawCommand { // Laid out the way glMultiDrawElementsIndirect expects it
+    GLuint count, instanceCount, firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+  };
+
+  unsigned int VAO{}, VBO{}, EBO{}, commandBuffer{}, centerBuffer{};
+  ProvinceBuffer colors{GL_RGBA8};
+  ProvinceBuffer values{GL_R32F}; // Floats, stored by their bits
+  std::vector<DrawCommand> commands[PROVINCE_LOD_LEVELS]; // One per province and level, visible or not
+  std::vector<AABB> bounds; // One per province
+  std::vector<DrawCommand> visibleCommands; // What's actually in the command buffer
+  AABB lastView; // What the visible commands were culled against, and at what level
+  size_t lastLevel = 0;
+  GLsizei drawCount = 0;
+  size_t vertexCount = 0, indexCount = 0;
+
+  [[nodiscard]] static uint32_t pack(const Province::Color color) {
+    return static_cast<uint32_t>(color.r) | static_cast<uint32_t>(color.g) << 8 |
+           static_cast<uint32_t>(color.b) << 16 | 0xFF000000u;
+  }
+};
+
+#endif // PROVINCE_MESH_HPP
@@ -0,0 +1,40 @@
+#ifndef PROVINCE_RASTER_H
+#define PROVINCE_RASTER_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../utils.hpp"
+
+// Which province every pixel of the map belongs to, by its index in the province file
+class ProvinceRaster {
+public:
+  static constexpr uint16_t NONE = 0xFFFF; // Pixels that don't belong to any province
+  static constexpr size_t MAX_PROVINCES = NONE;
+
+  ProvinceRaster() = default;
+  ProvinceRaster(const vec2i dimensions, std::vector<uint16_t> ids) : dimensions(dimensions), ids(std::move(ids)) {}
+  ~ProvinceRaster() = default;
+
+  [[nodiscard]] vec2i getDimensions() const { return dimensions; }
+  [[nodiscard]] const std::vector<uint16_t>& getIds() const { return ids; }
+  [[nodiscard]] bool empty() const { return ids.empty(); }
+
+  [[nodiscard]] uint16_t at(const int x, const int y) const {
+    if (x < 0 || y < 0 || x >= dimensions.x || y >= dimensions.y) return NONE;
+    return ids[static_cast<size_t>(y) * static_cast<size_t>(dimensions.x) + static_cast<size_t>(x)];
+  }
+
+  // Same coordinates the province meshes use, from -1 to 1, with y going up
+  [[nodiscard]] uint16_t atNDC(const float x, const float y) const {
+    return at(static_cast<int>(std::floor((x + 1.0f) * 0.5f * static_cast<float>(dimensions.x))),
+              static_cast<int>(std::floor((1.0f - y) * 0.5f * static_cast<float>(dimensions.y))));
+  }
+
+private:
+  vec2i dimensions;
+  std::vector<uint16_t> ids; // Row by row, from the top left
+};
+
+#endif // PROVINCE_RASTER_H
@@ -6,10 +6,21 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <filesystem>
 
 #include "../utils.hpp"
 #include "../error_handler/error_handler.h"
 
+#define SHADER_CACHE_PATH "cache/shaders" // Where linked program binaries get cached, empty to always compile
+#define SHADER_CACHE_VERSION 1 // Bump whenever the layout of the cached binaries changes
+
 class ErrorHandler;
 
 class Shader {
@@ -31,47 +42,60 @@ public:
 
   void use() const { glUseProgram(ID); }
 
+  // Location of a uniform, looked up once so setting it doesn't need any string lookups at all
+  struct Uniform {
+    GLint location = -1; // -1 if the program doesn't use it, which makes setting it do nothing, just like GL does
+  };
+  [[nodiscard]] Uniform getUniform(const std::string &name) const {
+    const auto it = std::ranges::lower_bound(uniforms, name, {}, &std::pair<std::string, GLint>::first);
+    return { it != uniforms.end() && it->first == name ? it->second : -1 };
+  }
+
   // --- Utility uniform functions ---
   // Boolean
-  void setBool(const std::string &name, const bool value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), static_cast<int>(value));
+  void setBool(const Uniform uniform, const bool value) const {
+    glUniform1i(uniform.location, static_cast<int>(value));
   }
+  void setBool(const std::string &name, const bool value) const { setBool(getUniform(name), value); }
   // Scalars
-  void setInt(const std::string &name, const int value) const {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
-  }
-  void setFloat(const std::string &name, const float value) const {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
-  }
-  void setDouble(const std::string &name, const double value) const {
-    glUniform1d(glGetUniformLocation(ID, name.c_str()), value); 
-  }
+  void setInt(const Uniform uniform, const int value) const { glUniform1i(uniform.location, value); }
+  void setInt(const std::string &name, const int value) const { setInt(getUniform(name), value); }
+  void setFloat(const Uniform uniform, const float value) const { glUniform1f(uniform.location, value); }
+  void setFloat(const std::string &name, const float value) const { setFloat(getUniform(name), value); }
+  void setDouble(const Uniform uniform, const double value) const { glUniform1d(uniform.location, value); }
+  void setDouble(const std::string &name, const double value) const { setDouble(getUniform(name), value); }
   // Vectors
-  void setVec2f(const std::string &name,
-                const float x,
-                const float y) const {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+  void setVec2f(const Uniform uniform, const float x, const float y) const { glUniform2f(uniform.location, x, y); }
+  void setVec2f(const std::string &name, const float x, const float y) const { setVec2f(getUniform(name), x, y); }
+  void setVec2f(const Uniform uniform, const vec2f &v) const { glUniform2f(uniform.location, v.x, v.y); }
+  void setVec2f(const std::string &name, const vec2f &v) const { setVec2f(getUniform(name), v); }
+  void setVec3f(const Uniform uniform, const float x, const float y, const float z) const {
+    glUniform3f(uniform.location, x, y, z);
   }
-  void setVec2f(const std::string &name,
-                const vec2f &v) const {
-    glUniform2f(glGetUniformLocation(ID, name.c_str()), v.x, v.y);
+  void setVec3f(const std::string &name, const float x, const float y, const float z) const {
+    setVec3f(getUniform(name), x, y, z);
   }
-  void setVec3f(const std::string &name,
-                const float x,
-                const float y,
-                const float z) const {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+  void setVec4f(const Uniform uniform, const float x, const float y, const float z, const float w) const {
+    glUniform4f(uniform.location, x, y, z, w);
   }
-  void setVec4f(const std::string &name,
-                const float x,
-                const float y,
-                const float z,
-                const float w) const {
-    glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+  void setVec4f(const std::string &name, const float x, const float y, const float z, const float w) const {
+    setVec4f(getUniform(name), x, y, z, w);
   }
 
+  // How long every shader so far took to load, compiled or not, in milliseconds
+  [[nodiscard]] static float getTotalLoadTime() { return totalLoadTime; }
+
 private:
+  struct BinaryHeader {
+    char magic[4];
+    uint32_t version;
+    GLenum format; // Whatever the driver says the binary is
+    uint32_t size;
+  };
+
   ErrorHandler* errorHandler;
+  std::vector<std::pair<std::string, GLint>> uniforms; // Every active uniform, sorted by name
+  static inline float totalLoadTime = 0.0f;
 
   void loadShaderCode(const std::string& vertexPath, const std::string& fragmentPath) {
     std::string vertexCode, fragmentCode;
@@ -96,6 +120,22 @@ private:
       errorHandler->logError("Shader file not successfully read: " + std::string(e.what()),
         ErrorHandler::FILE_NOT_SUCCESSFULLY_READ_ERROR);
     }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::string binaryPath = getBinaryPath(vertexCode, fragmentCode);
+    const bool cached = loadBinary(binaryPath);
+    if (!cached) {
+      compile(vertexCode, fragmentCode);
+      saveBinary(binaryPath);
+    } loadUniforms();
+
+    const auto time = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start);
+    totalLoadTime += time.count();
+    errorHandler->logDebug("Shader \"" + vertexPath + "\" " + (cached ? "loaded from the binary cache" : "compiled") +
+      " in " + std::to_string(time.count()) + "ms");
+  }
+
+  void compile(const std::string& vertexCode, const std::string& fragmentCode) {
     const char* vShaderCode = vertexCode.c_str();
     const char* fShaderCode = fragmentCode.c_str();
     
@@ -113,6 +153,7 @@ private:
     ID = glCreateProgram();
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
+    if (!std::string(SHADER_CACHE_PATH).empty()) glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
     
@@ -120,6 +161,91 @@ private:
     glDeleteShader(fragment);
   }
 
+  // Binaries only work on the exact same driver, so it goes in the key along with the sources
+  [[nodiscard]] static std::string getBinaryPath(const std::string& vertexCode, const std::string& fragmentCode) {
+    if (std::string(SHADER_CACHE_PATH).empty()) return "";
+    uint64_t hash = fnv1a(vertexCode.data(), vertexCode.size());
+    hash = fnv1a(fragmentCode.data(), fragmentCode.size(), hash);
+    for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+      const auto* string = reinterpret_cast<const char*>(glGetString(name));
+      if (string) hash = fnv1a(string, std::strlen(string), hash);
+    }
+    char file[32];
+    std::snprintf(file, sizeof(file), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return std::string(SHADER_CACHE_PATH) + "/" + file;
+  }
+
+  // False if there's no binary, or if the driver doesn't want it anymore, in which case we compile from source
+  bool loadBinary(const std::string& path) {
+    if (path.empty()) return false;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    BinaryHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, "CSHD", 4) != 0 ||
+        header.version != SHADER_CACHE_VERSION) return false;
+    std::error_code error;
+    if (header.size + sizeof(header) != std::filesystem::file_size(path, error) || error) return false; // Truncated
+    std::vector<char> binary(header.size);
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size()))) return false;
+
+    ID = glCreateProgram();
+    glProgramBinary(ID, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint success = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (success) return true;
+    errorHandler->logDebug("Shader binary \"" + path + "\" was rejected by the driver, compiling from source");
+    glDeleteProgram(ID);
+    ID = 0;
+    return false;
+  }
+
+  void saveBinary(const std::string& path) const {
+    if (path.empty()) return;
+    GLint formats = 0, length = 0, success = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (formats <= 0 || !success || length <= 0) return; // Nothing the driver can give us back later
+
+    BinaryHeader header{};
+    std::memcpy(header.magic, "CSHD", 4);
+    header.version = SHADER_CACHE_VERSION;
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLsizei written = 0;
+    glGetProgramBinary(ID, length, &written, &header.format, binary.data());
+    header.size = static_cast<uint32_t>(written);
+
+    std::error_code error;
+    std::filesystem::create_directories(SHADER_CACHE_PATH, error);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(binary.data(), written);
+    if (!file) errorHandler->logWarning("Could not write shader binary to \"" + path + "\"",
+      ErrorHandler::COULD_NOT_OPEN_FILE_ERROR);
+  }
+
+  // The program won't change after linking, so every uniform only has to be asked for once
+  void loadUniforms() {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<char> name(static_cast<size_t>(std::max(maxLength, 1)));
+    uniforms.clear();
+    uniforms.reserve(static_cast<size_t>(count));
+    for (GLint i = 0; i < count; i++) {
+      GLsizei length = 0;
+      GLint size = 0;
+      GLenum type = 0;
+      glGetActiveUniform(ID, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type,
+        name.data());
+      std::string uniformName(name.data(), static_cast<size_t>(length));
+      const GLint location = glGetUniformLocation(ID, uniformName.c_str());
+      if (location < 0) continue; // Part of a uniform block, which isn't set through here
+      if (uniformName.ends_with("[0]")) uniformName.resize(uniformName.size() - 3); // Arrays go by their name too
+      uniforms.emplace_back(std::move(uniformName), location);
+    } std::ranges::sort(uniforms);
+  }
+
   void checkCompileErrors(const unsigned int shader, const std::string &type) const {
     int success;
     char infoLog[1024];
@@ -10,30 +10,24 @@
 
 #define COLOR_HASH_SEED 196458761 // Random but constant seed for color generation
 
+typedef uint32_t StateId; // Dense handle of a state, in the order they were read in
+constexpr StateId NO_STATE = UINT32_MAX;
+
 class State {
 public:
   explicit State(std::string name) : name(std::move(name)) { checkColor(); }
   State(std::string name, const Province::Color color) : name(std::move(name)), color(color) { checkColor(); }
   ~State() = default;
 
-  State(const State& other) {
-    name = other.name;
-    provinces = other.provinces;
-    center = other.center;
-    color = other.color;
-  }
-
-  void addProvince(const Province& province) {
+  // Provinces are only referred to by their handles, so the center has to be passed along with them
+  void addProvince(const ProvinceId province, const vec2f& provinceCenter) {
     provinces.push_back(province);
-    center += province.getCenter();
+    center += provinceCenter;
   }
-  void removeProvince(const std::string& provinceName) {
-    for (auto it = provinces.begin(); it != provinces.end(); ++it) {
-      if (it->getName() == provinceName) {
-        provinces.erase(it);
-        center -= it->getCenter();
-        break;
-      }
+  void removeProvince(const ProvinceId province, const vec2f& provinceCenter) {
+    if (const auto it = std::ranges::find(provinces, province); it != provinces.end()) {
+      provinces.erase(it);
+      center -= provinceCenter;
     }
   }
   [[nodiscard]] vec2f getCenter() const { return center / static_cast<float>(provinces.size()); }
@@ -43,17 +37,15 @@ public:
   [[nodiscard]] std::string getName() const { return name; }
   [[nodiscard]] Province::Color getColor() const { return color; }
 
-  [[nodiscard]] bool hasProvince(const std::string &provinceName) const {
-    return std::ranges::any_of(provinces, [&provinceName](const Province& province) {
-      return province.getName() == provinceName;
-    });
+  [[nodiscard]] bool hasProvince(const ProvinceId province) const {
+    return std::ranges::find(provinces, province) != provinces.end();
   }
 
-  [[nodiscard]] std::vector<Province> getProvinces() const { return provinces; }
+  [[nodiscard]] const std::vector<ProvinceId>& getProvinces() const { return provinces; }
 
 private:
   std::string name;
-  std::vector<Province> provinces;
+  std::vector<ProvinceId> provinces;
   vec2f center;
 
   Province::Color color;
@@ -4,15 +4,21 @@ StateManager::StateManager(ErrorHandler* errorHandler,
                            const std::string& provShaderPath,
                            const std::string& textShaderPath,
                            const std::string& lineShaderPath,
+                           const std::string& mapShaderPath,
                            const std::string& mapPath,
                            const std::string& provPath,
-                           const std::string& statePath) : text(errorHandler), errorHandler(errorHandler) {
+                           const std::string& statePath,
+                           const std::string& cachePath) : text(errorHandler), errorHandler(errorHandler) {
   this->pm = std::make_unique<ProvinceManager>(errorHandler,
                                                provShaderPath,
                                                textShaderPath,
                                                lineShaderPath,
+                                               mapShaderPath,
                                                mapPath,
-                                               provPath);
+                                               provPath,
+                                               cachePath);
+
+  provinceStates.assign(pm->getProvinceCount(), NO_STATE);
 
   std::ifstream stateFile(statePath);
   if (!stateFile.is_open()) errorHandler->logFatal("Could not open file \"" + statePath + "\"",
@@ -28,7 +34,7 @@ StateManager::StateManager(ErrorHandler* errorHandler,
       errorHandler->logWarning("State with no ID found", ErrorHandler::FORMAT_ERROR);
       continue;
     }
-    if (states.contains(id)) {
+    if (stateLookup.contains(id)) {
       errorHandler->logWarning("State with ID " + id + " already exists", ErrorHandler::FORMAT_ERROR);
       continue;
     }
@@ -83,11 +89,34 @@ StateManager::StateManager(ErrorHandler* errorHandler,
       continue;
     }
 
+    const auto stateId = static_cast<StateId>(states.size());
     State state(name, color);
     for (const auto &provinceId: provinceIds) {
-      stateColors[provinceId] = state.getColor(); // Set the color of the province to the color of the state
-      state.addProvince(pm->getProvince(provinceId));
-    } states.emplace(id, state);
+      const ProvinceId province = pm->getProvinceId(provinceId);
+      if (province == NO_PROVINCE) {
+        errorHandler->logWarning("State " + id + " has an unknown province " + provinceId, ErrorHandler::FORMAT_ERROR);
+        continue;
+      }
+      if (provinceStates[province] != NO_STATE) {
+        errorHandler->logWarning("Province " + provinceId + " is already part of state " +
+          stateIds[provinceStates[province]] + ", so it can't be part of state " + id, ErrorHandler::FORMAT_ERROR);
+        continue;
+      }
+      provinceStates[province] = stateId;
+      pm->setProvinceColor(province, state.getColor()); // Set the color of the province to the color of the state
+      pm->setProvinceOwner(province, stateId);
+      state.addProvince(province, pm->getProvince(province).getCenter());
+    }
+
+    if (state.getProvinces().empty()) {
+      errorHandler->logError("State " + id + " has no valid provinces, skipping", ErrorHandler::FORMAT_ERROR);
+      continue;
+    }
+    stateLookup.emplace(id, stateId);
+    stateIds.push_back(id);
+    text.addLabel(id, STATE_LABEL_SIZE, state.getCenter());
+    states.push_back(std::move(state));
+    updateLabel(stateId);
   } stateFile.close();
 
   if (states.empty()) errorHandler->logFatal("No states found in \"" + statePath + "\"",
@@ -95,25 +124,51 @@ StateManager::StateManager(ErrorHandler* errorHandler,
 }
 
 void StateManager::render(const Window &window, const float scale, const vec2f &offset) {
-  pm->render(window, scale, offset, stateColors);
+  // Don't render text if zoomed in too close or too far or offscreen
+  const auto outscreen = vec2f(scale > 1.0f ? scale : 1.0f);
+  const bool labels = !(scale < 0.15f || scale > 2.0f || offset > outscreen || offset < -outscreen);
+  const auto dimensions = static_cast<vec2f>(window.getDimensions());
+
+  // State names get placed first, so province names only show up where there's no state name on top of them
+  if (labels) text.update(dimensions);
+  pm->render(window, scale, offset, labels ? &text : nullptr);
+  if (!labels) return;
 
   pm->textShader.use();
-  // Don't render text if zoomed in too close or too far or offscreen
-  if (const auto outscreen = vec2f(scale > 1.0f ? scale : 1.0f);
-      scale < 0.15f || scale > 2.0f || offset > outscreen ||offset < -outscreen) return;
-  for (auto &[name, state]: states) {
-    text.setText(name, 10.0f, state.getCenter(), static_cast<vec2f>(window.getDimensions()), offset);
-    pm->textShader.setVec2f("center", state.getCenter());
-    text.render();
-  }
+  text.render(dimensions, ProvinceManager::getView(scale, offset));
 }
 
 std::string StateManager::clickedOnState(const float x, const float y) const {
-  const std::string provinceName = pm->clickedOnProvince(x, y);
-  if (provinceName.empty()) return "";
-  const Province province = pm->getProvince(provinceName);
-  for (const auto &state: states | std::views::values)
-    if (state.hasProvince(province.getName())) return state.getName();
-  errorHandler->logError("Province " + provinceName + " not found in any state", ErrorHandler::UNKNOWN_ERROR);
+  const ProvinceId province = pm->clickedOnProvinceId(x, y);
+  if (province == NO_PROVINCE) return "";
+  if (const StateId state = provinceStates[province]; state != NO_STATE) return states[state].getName();
+  errorHandler->logError("Province " + pm->getProvinceIdString(province) + " not found in any state",
+    ErrorHandler::UNKNOWN_ERROR);
   return "";
 }
+
+void StateManager::setProvinceState(const ProvinceId province, const StateId state) {
+  const StateId oldState = provinceStates[province];
+  if (oldState == state) return;
+  const vec2f center = pm->getProvince(province).getCenter();
+  if (oldState != NO_STATE) {
+    states[oldState].removeProvince(province, center);
+    updateLabel(oldState);
+  } provinceStates[province] = state;
+  if (state != NO_STATE) {
+    states[state].addProvince(province, center);
+    updateLabel(state);
+  }
+  pm->setProvinceColor(province, state != NO_STATE ? states[state].getColor() : Province::Color());
+  pm->setProvinceOwner(province, state);
+}
+
+void StateManager::updateLabel(const StateId state) {
+  const bool empty = states[state].getProvinces().empty(); // Lost all of its provinces, so it has no center either
+  text.setVisible(state, !empty);
+  if (empty) return;
+  text.setCenter(state, states[state].getCenter());
+  size_t area = 0; // Bigger states keep their names when they'd overlap
+  for (const ProvinceId province : states[state].getProvinces()) area += pm->getProvince(province).getArea();
+  text.setPriority(state, static_cast<float>(area));
+}
@@ -5,6 +5,8 @@
 #include <map>
 #include <memory>
 #include <ranges>
+#include <vector>
+#include <unordered_map>
 
 #include "../utils.hpp"
 #include "../window/window.hpp"
@@ -14,6 +16,8 @@
 #include "../text/text.hpp"
 #include "../error_handler/error_handler.h"
 
+#define STATE_LABEL_SIZE 10.0f // Font size of the state names, in pixels when fully zoomed out
+
 class StateManager {
 public:
   std::unique_ptr<ProvinceManager> pm;
@@ -22,37 +26,54 @@ public:
                         const std::string& provShaderPath = "res/shaders/default",
                         const std::string& textShaderPath = "res/shaders/text",
                         const std::string& lineShaderPath = "res/shaders/line",
+                        const std::string& mapShaderPath = "res/shaders/map",
                         const std::string& mapPath = "res/test.png",
                         const std::string& provPath = "res/provinces.txt",
-                        const std::string& statePath = "res/states.txt");
+                        const std::string& statePath = "res/states.txt",
+                        const std::string& cachePath = "cache/map.cache");
   ~StateManager() = default;
 
   StateManager(const StateManager&) = delete;
   StateManager& operator=(const StateManager&) = delete;
 
   void render(const Window &window, float scale, const vec2f &offset);
+  [[nodiscard]] StateId clickedOnStateId(const float x, const float y) const {
+    const ProvinceId province = pm->clickedOnProvinceId(x, y);
+    return province == NO_PROVINCE ? NO_STATE : provinceStates[province];
+  }
   [[nodiscard]] std::string clickedOnState(float x, float y) const;
   [[nodiscard]] std::string clickedOnState(const vec2f& pos) const { return clickedOnState(pos.x, pos.y); }
 
+  [[nodiscard]] StateId getStateId(const std::string& id) const {
+    const auto it = stateLookup.find(id);
+    return it == stateLookup.end() ? NO_STATE : it->second;
+  }
+  [[nodiscard]] const std::string& getStateIdString(const StateId state) const { return stateIds[state]; }
+  [[nodiscard]] StateId getProvinceState(const ProvinceId province) const { return provinceStates[province]; }
+  void setProvinceState(ProvinceId province, StateId state); // NO_STATE leaves it without one
+
   [[nodiscard]] Province& getProvince(const std::string& name) const { return pm->getProvince(name); }
-  [[nodiscard]] State& getState(const std::string& name) { return states.at(name); }
+  [[nodiscard]] State& getState(const StateId state) { return states[state]; }
+  [[nodiscard]] State& getState(const std::string& name) { return states[stateLookup.at(name)]; }
 
-  [[nodiscard]] std::vector<State> getAllStates() const {
-    std::vector<State> stateList;
-    stateList.reserve(states.size());
-    for (const auto &state: states | std::views::values) stateList.push_back(state);
-    return stateList;
+  [[nodiscard]] std::vector<State> getAllStates() const { return states; }
+  [[nodiscard]] std::map<std::string, State> getAllStatesMap() const {
+    std::map<std::string, State> stateMap;
+    for (StateId i = 0; i < states.size(); i++) stateMap.emplace(stateIds[i], states[i]);
+    return stateMap;
   }
-  [[nodiscard]] std::map<std::string, State> getAllStatesMap() const { return states; }
 
   void tick() const { pm->tick(); }
 
 private:
-  std::map<std::string, State> states;
-  Text text;
+  std::vector<State> states; // Indexed by StateId
+  std::vector<std::string> stateIds; // The other way around
+  std::unordered_map<std::string, StateId> stateLookup;
+  std::vector<StateId> provinceStates; // Which state every province belongs to
+  Text text; // Every state name, labels have the same handles as the states
   ErrorHandler* errorHandler;
 
-  std::unordered_map<std::string, Province::Color> stateColors;
+  void updateLabel(StateId state); // Moves its name to wherever its center is now, and reweighs it by its area
 };
 
 #endif // STATE_MANAGER_HPP
@@ -60,6 +60,19 @@ errorHandler(errorHandler) {
 
   glGenVertexArrays(1, &VAO);
   glGenBuffers(1, &VBO);
+
+  // The buffer gets (re)allocated on the first layout, the attributes don't change after that
+  glBindVertexArray(VAO);
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, position)));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                        reinterpret_cast<void *>(offsetof(Vertex, texCoords)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<void *>(offsetof(Vertex, center)));
+  glEnableVertexAttribArray(2);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 Text::~Text() {
@@ -68,17 +81,70 @@ Text::~Text() {
   glDeleteBuffers(1, &VBO);
 }
 
-void Text::setText(const std::string &text,
-                   const float scale,
-                   vec2f position,
-                   const vec2f &windowDimensions,
-                   const vec2f &offset) {
-  size = 0;
-  std::vector<float> vertices;
-  position = (position + 0.5f) * windowDimensions - vec2f(scale, 0.0f);
-  vec2f textOffset = position;
-  for (unsigned int i = 0; i < text.size(); i++) {
-    const char c = text.c_str()[i];
+Text::Label Text::addLabel(const std::string &text, const float scale, const vec2f &center, const float priority) {
+  labels.push_back({ text, scale, center, priority, true, false, 0, 0, AABB() });
+  dirty = true;
+  return static_cast<Label>(labels.size() - 1);
+}
+
+void Text::setText(const Label label, const std::string &text) {
+  if (labels[label].text == text) return;
+  labels[label].text = text;
+  dirty = true;
+}
+
+void Text::setCenter(const Label label, const vec2f &center) {
+  LabelData& data = labels[label];
+  if (data.center == center) return;
+  const vec2f delta = onMap(center, vec2f()) - onMap(data.center, vec2f());
+  if (!data.bounds.empty()) data.bounds = { data.bounds.min + delta, data.bounds.max + delta };
+  data.center = center;
+  if (dirty) return; // Gets laid out from scratch anyway
+
+  // Glyphs are relative to the center, so moving a label doesn't need laying it out again
+  const auto first = static_cast<size_t>(data.first), last = first + static_cast<size_t>(data.count);
+  for (size_t i = first; i < last; i++) vertices[i].center = center;
+  dirtyBegin = std::min(dirtyBegin, first);
+  dirtyEnd = std::max(dirtyEnd, last);
+  placementDirty = true;
+}
+
+void Text::setPriority(const Label label, const float priority) {
+  if (labels[label].priority == priority) return;
+  labels[label].priority = priority;
+  placementDirty = true;
+}
+
+void Text::setVisible(const Label label, const bool visible) {
+  if (labels[label].visible == visible) return;
+  labels[label].visible = visible;
+  placementDirty = true;
+}
+
+void Text::layout(const vec2f &windowDimensions) {
+  vertices.clear();
+  for (auto& label : labels) layoutLabel(label, windowDimensions);
+
+  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+  if (vertices.size() > capacity) {
+    capacity = std::max(vertices.size(), capacity * 2);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity * sizeof(Vertex)), nullptr, GL_DYNAMIC_DRAW);
+  } glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex)), vertices.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  lastDimensions = windowDimensions;
+  placementDirty = true;
+  dirty = false;
+  dirtyBegin = SIZE_MAX;
+  dirtyEnd = 0;
+}
+
+void Text::layoutLabel(LabelData &label, const vec2f &windowDimensions) {
+  label.first = static_cast<GLint>(vertices.size());
+  const float scale = label.scale;
+  vec2f textOffset; // From the start of the label
+  AABB box; // Of every glyph, in pixels, so the label can be centered on it afterward
+  for (const char c : label.text) {
     switch (c) {
       case 9: // Horizontal tab (\t)
       case 12: // Form feed (\f)
@@ -86,13 +152,13 @@ void Text::setText(const std::string &text,
         continue;
       case 10: // Line feed (\n)
         textOffset.y -= scale;
-        textOffset.x = position.x;
+        textOffset.x = 0.0f;
         continue;
       case 11 : // Vertical tab (\v)
         textOffset.y -= scale;
         continue;
       case 13: // Carriage return (\r)
-        textOffset.x = position.x;
+        textOffset.x = 0.0f;
         continue;
       default: break;
     }
@@ -112,45 +178,140 @@ void Text::setText(const std::string &text,
     if (quadLeft == quadRight || quadBottom == quadTop) {
       textOffset.x += advance * scale;
       continue;
-    };
-
-    const vec2f q0 = (textOffset + vec2f(quadLeft, quadBottom) * scale) * 2.0f / windowDimensions- 1.0f;
-    const vec2f q1 = (textOffset + vec2f(quadRight, quadTop) * scale) * 2.0f / windowDimensions - 1.0f;
+    }
 
+    const vec2f q0 = textOffset + vec2f(quadLeft, quadBottom) * scale;
+    const vec2f q1 = textOffset + vec2f(quadRight, quadTop) * scale;
+    box.add(q0);
+    box.add(q1);
 
+    // Two triangles, so every glyph of every label can go in the same draw
     vertices.insert(vertices.end(), {
-      q0.x, q0.y, atlasLeft, atlasBottom,
-      q1.x, q0.y, atlasRight, atlasBottom,
-      q0.x, q1.y, atlasLeft, atlasTop,
-      q1.x, q1.y, atlasRight, atlasTop
+      { q0, { atlasLeft, atlasBottom }, label.center },
+      { { q1.x, q0.y }, { atlasRight, atlasBottom }, label.center },
+      { { q0.x, q1.y }, { atlasLeft, atlasTop }, label.center },
+      { { q0.x, q1.y }, { atlasLeft, atlasTop }, label.center },
+      { { q1.x, q0.y }, { atlasRight, atlasBottom }, label.center },
+      { q1, { atlasRight, atlasTop }, label.center }
     });
 
     textOffset.x += advance * scale;
-    size++;
   }
 
-  glBindVertexArray(VAO);
-  glBindBuffer(GL_ARRAY_BUFFER, VBO);
-  glBufferData(GL_ARRAY_BUFFER,
-               static_cast<GLsizeiptr>(vertices.size() * sizeof(float)),
-               &vertices[0],
-               GL_STATIC_DRAW);
+  label.count = static_cast<GLsizei>(vertices.size()) - label.first;
+  label.bounds = AABB();
+  if (box.empty()) return;
 
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
-  glEnableVertexAttribArray(0);
+  // From pixels to the same coordinates as the map, centered on the label's center
+  const vec2f middle = (box.min + box.max) / 2.0f;
+  for (size_t i = static_cast<size_t>(label.first); i < vertices.size(); i++) {
+    vertices[i].position = (vertices[i].position - middle) * 2.0f / windowDimensions;
+    label.bounds.add(onMap(label.center, vertices[i].position));
+  }
+}
 
-  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), reinterpret_cast<void *>(2 * sizeof(float)));
-  glEnableVertexAttribArray(1);
+void Text::place(const Text* above) {
+  // Text scales along with the map, so labels overlap at every zoom or at none, and this only depends on the layout
+  // Cells are as big as an average label, so every label only ever has to be checked against a few others
+  cellSize = vec2f();
+  size_t boxes = 0;
+  for (const auto& label : labels) {
+    if (label.bounds.empty()) continue;
+    cellSize += label.bounds.max - label.bounds.min;
+    boxes++;
+  }
+  cellSize = boxes > 0 ? cellSize / static_cast<float>(boxes) : vec2f(1.0f);
+  if (cellSize.x <= 0.0f || cellSize.y <= 0.0f) cellSize = vec2f(1.0f);
 
-  glBindVertexArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  order.resize(labels.size());
+  std::iota(order.begin(), order.end(), Label(0));
+  std::ranges::stable_sort(order, std::ranges::greater(), [&](const Label label) { return labels[label].priority; });
+
+  for (auto& cell : cells) cell.second.clear(); // Keep the buckets around, the same cells get used again mostly
+  placedCount = 0;
+  for (const Label i : order) {
+    LabelData& label = labels[i];
+    label.placed = false;
+    if (!label.visible || label.count == 0) continue;
+    // Whatever is drawn on top wins, so the labels under it can still take the space one of theirs would have had
+    if ((above && above->overlapsPlaced(label.bounds)) || overlapsPlaced(label.bounds)) continue;
+
+    const auto [x0, y0, x1, y1] = cellRange(label.bounds);
+    for (int32_t y = y0; y <= y1; y++)
+      for (int32_t x = x0; x <= x1; x++) cells[cellKey(x, y)].push_back(i);
+    label.placed = true;
+    placedCount++;
+  }
+
+  placements++;
+  lastAbove = above;
+  lastAbovePlacements = above ? above->placements : 0;
+  placementDirty = false;
 }
 
-void Text::render() const {
+Text::CellRange Text::cellRange(const AABB &bounds) const {
+  return {
+    static_cast<int32_t>(std::floor(bounds.min.x / cellSize.x)),
+    static_cast<int32_t>(std::floor(bounds.min.y / cellSize.y)),
+    static_cast<int32_t>(std::floor(bounds.max.x / cellSize.x)),
+    static_cast<int32_t>(std::floor(bounds.max.y / cellSize.y))
+  };
+}
+
+bool Text::overlapsPlaced(const AABB &bounds) const {
+  const auto [x0, y0, x1, y1] = cellRange(bounds);
+  for (int32_t y = y0; y <= y1; y++) {
+    for (int32_t x = x0; x <= x1; x++) {
+      const auto it = cells.find(cellKey(x, y));
+      if (it == cells.end()) continue;
+      if (std::ranges::any_of(it->second, [&](const Label other) { return labels[other].bounds.intersects(bounds); }))
+        return true;
+    }
+  } return false;
+}
+
+void Text::update(const vec2f &windowDimensions, const Text* above) {
+  if (windowDimensions.x <= 0.0f || windowDimensions.y <= 0.0f) return; // Minimized
+  if (dirty || windowDimensions != lastDimensions) layout(windowDimensions);
+  else if (dirtyBegin < dirtyEnd) {
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    static_cast<GLintptr>(dirtyBegin * sizeof(Vertex)),
+                    static_cast<GLsizeiptr>((dirtyEnd - dirtyBegin) * sizeof(Vertex)),
+                    vertices.data() + dirtyBegin);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    dirtyBegin = SIZE_MAX;
+    dirtyEnd = 0;
+  }
+
+  if (placementDirty || above != lastAbove || (above && above->placements != lastAbovePlacements)) {
+    place(above);
+    lastView = AABB();
+  }
+}
+
+void Text::render(const vec2f &windowDimensions, const AABB &view, const Text* above) {
+  if (windowDimensions.x <= 0.0f || windowDimensions.y <= 0.0f) return; // Minimized
+  update(windowDimensions, above);
+
+  if (view != lastView) { // The camera moved, so redo the culling
+    firsts.clear();
+    counts.clear();
+    for (const auto& label : labels) {
+      if (!label.placed || !label.bounds.intersects(view)) continue;
+      if (!firsts.empty() && firsts.back() + counts.back() == label.first) counts.back() += label.count;
+      else {
+        firsts.push_back(label.first);
+        counts.push_back(label.count);
+      }
+    } lastView = view;
+  }
+
+  if (firsts.empty()) return;
   glBindVertexArray(VAO);
   glActiveTexture(GL_TEXTURE0);
   glBindTexture(GL_TEXTURE_2D, atlas);
-  for (unsigned int i = 0; i < size; i++) glDrawArrays(GL_TRIANGLE_STRIP, static_cast<GLint>(i * 4), 4);
+  glMultiDrawArrays(GL_TRIANGLES, firsts.data(), counts.data(), static_cast<GLsizei>(firsts.size()));
   glBindVertexArray(0);
   glBindTexture(GL_TEXTURE_2D, 0);
 }
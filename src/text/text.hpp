@@ -6,6 +6,10 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <cstdint>
+#include <cstddef>
+#include <numeric>
+#include <unordered_map>
 
 #include "../utils.hpp"
 #include "../province/province.hpp" // Include for stb_image
@@ -17,21 +21,91 @@ struct Character {
   float atlasLeft, atlasBottom, atlasRight, atlasTop;
 };
 
+// A batch of labels, all laid out into the same vertex buffer and drawn with a single call
+// Glyphs only get laid out again when a label changes or the window gets resized, not every frame
+// Labels that would overlap one with a higher priority don't get drawn at all, nor ones under a batch drawn on top
 class Text {
 public:
+  typedef uint32_t Label; // Handle of a label, in the order they were added
+
   explicit Text(ErrorHandler* errorHandler,
                 const std::string &atlasPath = "res/text.png",
                 const std::string &indexPath = "res/text.csv");
   ~Text();
 
-  void setText(const std::string &text, float scale, vec2f position, const vec2f &windowDimensions, const vec2f &offset);
-  void render() const;
+  Text(const Text&) = delete;
+  Text& operator=(const Text&) = delete;
+
+  // Scale is the size of the font in pixels, and the text is centered on the given point of the map
+  Label addLabel(const std::string &text, float scale, const vec2f &center, float priority = 0.0f);
+  void setText(Label label, const std::string &text);
+  void setCenter(Label label, const vec2f &center);
+  void setPriority(Label label, float priority);
+  void setVisible(Label label, bool visible); // Hidden labels are still laid out, just never drawn, nor in the way
+  [[nodiscard]] size_t getLabelCount() const { return labels.size(); }
+  [[nodiscard]] size_t getPlacedCount() const { return placedCount; } // Out of the visible ones
+
+  // Lays out and places whatever changed, labels overlapping any placed label of above are left out
+  // Only call this from the thread that owns the GL context
+  void update(const vec2f &windowDimensions, const Text* above = nullptr);
+  // Only labels that are at least partly in view get drawn, above has to be updated first
+  // Only call this from the thread that owns the GL context
+  void render(const vec2f &windowDimensions, const AABB &view, const Text* above = nullptr);
 
 private:
+  struct Vertex {
+    vec2f position; // Relative to the center, scaled to the window
+    vec2f texCoords;
+    vec2f center;
+  };
+  struct CellRange { // Of the spatial hash, inclusive
+    int32_t x0, y0, x1, y1;
+  };
+  struct LabelData {
+    std::string text;
+    float scale;
+    vec2f center;
+    float priority; // Higher goes first
+    bool visible = true;
+    bool placed = false; // Visible, and not overlapping any label with a higher priority
+    GLint first = 0; // Where its glyphs are in the vertex buffer
+    GLsizei count = 0;
+    AABB bounds; // On the map
+  };
+
   std::vector<Character> characters;
+  std::vector<LabelData> labels; // Indexed by Label
+  std::vector<Vertex> vertices; // Every glyph of every label, 6 vertices each
+  std::vector<GLint> firsts; // What's going to be drawn, merged whenever labels are next to each other
+  std::vector<GLsizei> counts;
   GLuint atlas{}, VAO{}, VBO{};
-  unsigned int size{};
+  size_t capacity = 0; // In vertices, the buffer only gets reallocated when it has to grow
+  vec2f lastDimensions; // What the glyphs were laid out for
+  AABB lastView; // What the labels were culled against
+  bool dirty = true; // Something changed, so everything has to be laid out again
+  bool placementDirty = true; // Something moved, so which labels overlap has to be worked out again
+  size_t placedCount = 0;
+  size_t placements = 0; // Times the labels were placed, so batches under this one know when to place theirs again
+  const Text* lastAbove = nullptr; // What the labels were placed under
+  size_t lastAbovePlacements = 0;
+  vec2f cellSize = vec2f(1.0f);
+  std::vector<Label> order; // Labels by priority, kept around so placing them again doesn't allocate
+  std::unordered_map<uint64_t, std::vector<Label>> cells; // Spatial hash of the placed labels
+  size_t dirtyBegin = SIZE_MAX, dirtyEnd = 0; // Vertices that only moved, so they just have to be uploaded again
   ErrorHandler* errorHandler;
+
+  // Where the text shader ends up putting a vertex, before the camera, same as it does for the province meshes
+  [[nodiscard]] static vec2f onMap(const vec2f &center, const vec2f &position) {
+    return (center + position) * 0.9f + center;
+  }
+  void layout(const vec2f &windowDimensions);
+  void layoutLabel(LabelData &label, const vec2f &windowDimensions);
+  void place(const Text* above);
+  [[nodiscard]] CellRange cellRange(const AABB &bounds) const;
+  [[nodiscard]] static uint64_t cellKey(const int32_t x, const int32_t y) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+  }
+  [[nodiscard]] bool overlapsPlaced(const AABB &bounds) const; // Any label placed so far
 };
 
 #endif // TEXT_HPP
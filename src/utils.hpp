@@ -4,6 +4,9 @@
 #include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
 
 template <typename T>
 struct vec2 {
@@ -161,4 +164,40 @@ typedef vec2<int> vec2i;
 typedef vec2<float> vec2f;
 typedef vec2<double> vec2d;
 
+// Axis-aligned bounding box, empty until something gets added to it
+struct AABB {
+    vec2f min = vec2f(std::numeric_limits<float>::infinity());
+    vec2f max = vec2f(-std::numeric_limits<float>::infinity());
+
+    AABB() = default;
+    AABB(const vec2f& min, const vec2f& max) : min(min), max(max) {}
+
+    void add(const vec2f& p) {
+        min = vec2f(std::min(min.x, p.x), std::min(min.y, p.y));
+        max = vec2f(std::max(max.x, p.x), std::max(max.y, p.y));
+    }
+    void add(const AABB& other) {
+        if (other.empty()) return;
+        add(other.min);
+        add(other.max);
+    }
+
+    [[nodiscard]] bool empty() const { return min.x > max.x || min.y > max.y; }
+    [[nodiscard]] bool intersects(const AABB& other) const { // Never true for empty boxes
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    bool operator==(const AABB& other) const { return min == other.min && max == other.max; }
+};
+
+// 64-bit FNV-1a, for content hashes (not for anything security related)
+// Pass the result of a previous call as hash to keep hashing from where it left off
+[[nodiscard]] inline uint64_t fnv1a(const void* data, const size_t size, uint64_t hash = 14695981039346656037ull) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    } return hash;
+}
+
 #endif // UTILS_HPP
@@ -0,0 +1,35 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+// Spreads independent jobs across a set of worker threads
+class WorkerPool {
+public:
+  // 0 threads means one per hardware thread, 1 thread runs everything serially on the calling thread
+  explicit WorkerPool(const size_t threads = 0) :
+  threads(threads > 0 ? threads : std::max<size_t>(1, std::thread::hardware_concurrency())) {}
+  ~WorkerPool() = default;
+
+  [[nodiscard]] size_t size() const { return threads; }
+
+  // Runs job(i) for every i in [0, count), and blocks until all of them are done
+  // Jobs may run in any order, so they must not depend on each other
+  void run(const size_t count, const std::function<void(size_t)>& job) const {
+    std::atomic<size_t> next = 0;
+    const auto work = [&] { for (size_t i; (i = next++) < count;) job(i); };
+
+    std::vector<std::jthread> workers; // Joined when they go out of scope
+    for (size_t i = 1; i < std::min(threads, count); i++) workers.emplace_back(work);
+    work(); // The calling thread works too
+  }
+
+private:
+  size_t threads;
+};
+
+#endif // WORKER_POOL_H